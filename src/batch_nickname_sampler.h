@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "bounded_random.h"
+#include "nickname_key.h"
+#include "prefetch.h"
+#include "sample_nickname.h"
+#include "sample_nickname_opt.h"
+#include "types.h"
+#include "word_db.h"
+
+// sample_nickname_key와 같은 분포의 닉네임 키를 BATCH_SIZE개씩 묶어 생성한다. 난수 스트림은 다르다.
+// 문자열을 만들지 않고 WordDB::packed_words의 키 위에서 6비트 필드 단위로 조각을 변형하고 이어 붙인다.
+// - 묶음의 모든 닉네임의 조각 구성과 단어를 먼저 정하고 단어의 키를 프리페치한 뒤, 두 번째 단계에서 변형하고 조립한다.
+//   단어의 길이는 인덱스만으로 정해지므로 첫 단계에서는 단어를 읽지 않는다.
+// - 대문자 변환은 첫 필드의 코드에서 26을 빼는 것으로 끝난다.
+// - 변형할 위치는 길이별로 미리 만들어 둔 위치 집합의 필드 마스크 중 하나를 한 번에 뽑는다.
+//   균등한 부분 Fisher-Yates가 고르는 위치 집합 역시 균등하므로 분포는 같다.
+// - 모든 위치에 변형된 문자를 채운 키를 문자 두 개씩 표에서 만들고 마스크로 합쳐, 위치마다 분기하지 않는다.
+// 모든 단계는 스칼라 코드이며, 기본 옵션에서 sample_nickname_key보다 약 2배 빠르다.
+class BatchNicknameSampler
+{
+  public:
+    constexpr static auto BATCH_SIZE = PREFETCH_BATCH_SIZE;
+
+    BatchNicknameSampler(WordDB const &word_db, SampleNicknameOpt const &opt)
+        : word_db_(word_db), opt_(opt), first_word_(word_db.first_index[opt.min_word_len])
+    {
+        for (auto chance = opt.min_word_len; chance <= opt.max_len; ++chance)
+        {
+            num_word_choices_[chance] = word_db.num_words(opt.min_word_len, std::min(opt.max_word_len, chance));
+            if (num_word_choices_[chance] == 0)
+            {
+                constexpr auto msg = "there are no words to sample";
+                spdlog::critical(msg);
+                throw std::runtime_error(msg);
+            }
+        }
+        for (auto len = opt.min_word_len; len <= std::min(opt.max_word_len, opt.max_len); ++len)
+        {
+            auto const num_mangled = num_mangled_chars(len, opt.mangling_factor);
+            for (auto positions = u32(); positions < (static_cast<u32>(1) << len); ++positions)
+            {
+                if (static_cast<sz>(std::popcount(positions)) != num_mangled)
+                {
+                    continue;
+                }
+                auto mask = NicknameKey();
+                for (auto pos = sz(); pos < len; ++pos)
+                {
+                    mask |= (positions >> pos & 1) != 0 ? SYMBOL_MASK << (pos * NICKNAME_SYMBOL_BITS) : 0;
+                }
+                mangle_masks_[len].push_back(mask);
+            }
+        }
+    }
+
+    template <typename RandomEngine>
+    void sample(RandomEngine &random_engine, std::span<NicknameKey> const out) const
+    {
+        auto digits = Digits();
+        auto plans = std::array<Plan, BATCH_SIZE>();
+        for (auto begin = sz(); begin < out.size(); begin += BATCH_SIZE)
+        {
+            auto const count = std::min(BATCH_SIZE, out.size() - begin);
+            for (auto i = sz(); i < count; ++i)
+            {
+                plan(random_engine, digits, plans[i]);
+            }
+            for (auto i = sz(); i < count; ++i)
+            {
+                out[begin + i] = assemble(random_engine, digits, plans[i]);
+            }
+        }
+    }
+
+  private:
+    constexpr static auto NO_WORD = std::numeric_limits<u32>::max();
+    constexpr static auto SYMBOL_MASK = (static_cast<NicknameKey>(1) << NICKNAME_SYMBOL_BITS) - 1;
+    constexpr static auto UPPER_A_CODE = NICKNAME_SYMBOL_CODES['A'];
+    constexpr static auto LOWER_A_CODE = NICKNAME_SYMBOL_CODES['a'];
+
+    // sample_ascii_folded와 같이 심볼을 소문자로 접은 코드
+    constexpr static auto FOLDED_CODES = []() {
+        auto codes = std::array<u8, NICKNAME_SYMBOLS.length()>();
+        for (auto i = sz(); i < codes.size(); ++i)
+        {
+            auto const ch = NICKNAME_SYMBOLS[i];
+            codes[i] = NICKNAME_SYMBOL_CODES[static_cast<u8>('A' <= ch && ch <= 'Z' ? ch - 'A' + 'a' : ch)];
+        }
+        return codes;
+    }();
+
+    // 심볼 두 개(i % 62, i / 62)를 접은 코드를 이어 붙인 12비트 값
+    constexpr static auto FOLDED_PAIR_CODES = []() {
+        auto codes = std::array<u16, FOLDED_CODES.size() * FOLDED_CODES.size()>();
+        for (auto i = sz(); i < codes.size(); ++i)
+        {
+            codes[i] = static_cast<u16>(FOLDED_CODES[i % FOLDED_CODES.size()] |
+                                        FOLDED_CODES[i / FOLDED_CODES.size()] << NICKNAME_SYMBOL_BITS);
+        }
+        return codes;
+    }();
+
+    struct Digits
+    {
+        SymbolDigits symbols;
+        RandomDigits<26> letters;
+        RandomDigits<FOLDED_PAIR_CODES.size()> symbol_pairs;
+    };
+
+    // word가 NO_WORD라면 code는 채움 문자열의 키이다.
+    struct Piece
+    {
+        NicknameKey code;
+        u32 word;
+        u32 len;
+    };
+
+    struct Plan
+    {
+        std::array<Piece, MAX_PACKED_NICKNAME_LEN> pieces;
+        sz num_pieces;
+    };
+
+    template <typename RandomEngine>
+    static NicknameKey sample_filler(RandomEngine &random_engine, Digits &digits, sz const len)
+    {
+        auto key = static_cast<NicknameKey>(LOWER_A_CODE + digits.letters.next(random_engine));
+        for (auto pos = static_cast<sz>(1); pos < len; ++pos)
+        {
+            key |= (digits.symbols.next(random_engine) + 1) << (pos * NICKNAME_SYMBOL_BITS);
+        }
+        return key;
+    }
+
+    // 길이가 l 이상인 단어의 인덱스는 first_index[l] 이상이므로, 분기 없이 비교 결과를 더한다.
+    u32 word_len(u32 const word) const noexcept
+    {
+        auto len = opt_.min_word_len;
+        for (auto l = opt_.min_word_len + 1; l <= opt_.max_word_len; ++l)
+        {
+            len += word_db_.first_index[l] <= word ? 1 : 0;
+        }
+        return static_cast<u32>(len);
+    }
+
+    template <typename RandomEngine>
+    void plan(RandomEngine &random_engine, Digits &digits, Plan &out) const
+    {
+        auto chance = opt_.min_len;
+        if (opt_.min_len < opt_.max_len)
+        {
+            chance += static_cast<sz>(bounded_random(random_engine, opt_.max_len - opt_.min_len + 1));
+        }
+        out.num_pieces = 0;
+        while (0 < chance)
+        {
+            auto &piece = out.pieces[out.num_pieces++];
+            if (chance < opt_.min_word_len)
+            {
+                piece = Piece{sample_filler(random_engine, digits, chance), NO_WORD, static_cast<u32>(chance)};
+                break;
+            }
+            auto const word = static_cast<u32>(first_word_ + bounded_random(random_engine, num_word_choices_[chance]));
+            prefetch_read(&word_db_.packed_words[word]);
+            piece = Piece{EMPTY_NICKNAME_KEY, word, word_len(word)};
+            chance -= piece.len;
+        }
+    }
+
+    template <typename RandomEngine>
+    NicknameKey mangle(RandomEngine &random_engine, Digits &digits, NicknameKey key, u32 const len) const
+    {
+        // 첫 글자가 소문자라면 대문자로 바꾼다.
+        key -= (key & SYMBOL_MASK) >= LOWER_A_CODE ? LOWER_A_CODE - UPPER_A_CODE : 0;
+
+        auto const &masks = mangle_masks_[len];
+        auto const mask = masks.size() == 1 ? masks.front() : masks[bounded_random(random_engine, masks.size())];
+        if (mask == 0)
+        {
+            return key;
+        }
+        // 변형된 첫 글자는 균등한 대문자, 나머지는 접은 심볼이다.
+        auto mangled = static_cast<NicknameKey>(UPPER_A_CODE + digits.letters.next(random_engine));
+        for (auto shift = static_cast<sz>(NICKNAME_SYMBOL_BITS); shift < len * NICKNAME_SYMBOL_BITS;
+             shift += 2 * NICKNAME_SYMBOL_BITS)
+        {
+            mangled |= static_cast<NicknameKey>(FOLDED_PAIR_CODES[digits.symbol_pairs.next(random_engine)]) << shift;
+        }
+        return (key & ~mask) | (mangled & mask);
+    }
+
+    template <typename RandomEngine>
+    NicknameKey assemble(RandomEngine &random_engine, Digits &digits, Plan &plan) const
+    {
+        auto const pieces = std::span(plan.pieces.data(), plan.num_pieces);
+        for (auto &piece : pieces)
+        {
+            if (piece.word != NO_WORD)
+            {
+                piece.code = mangle(random_engine, digits, word_db_.packed_words[piece.word], piece.len);
+            }
+        }
+        shuffle(random_engine, pieces);
+
+        auto key = NicknameKey();
+        auto shift = sz();
+        for (auto const &piece : pieces)
+        {
+            key |= piece.code << shift;
+            shift += piece.len * NICKNAME_SYMBOL_BITS;
+        }
+        return key;
+    }
+
+    WordDB const &word_db_;
+    SampleNicknameOpt opt_;
+    sz first_word_;
+    std::array<sz, MAX_NICKNAME_LEN + 1> num_word_choices_{};
+    std::array<std::vector<NicknameKey>, MAX_NICKNAME_LEN + 1> mangle_masks_;
+};
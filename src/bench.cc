@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "batch_nickname_sampler.h"
+#include "cli.h"
+#include "composition_plan.h"
+#include "concurrent_nickname_set.h"
+#include "flat_nickname_set.h"
+#include "nickname_key.h"
+#include "random_engines.h"
+#include "sample_nickname.h"
+#include "sample_nickname_opt.h"
+#include "types.h"
+#include "word_db.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// 닉네임 생성과 닉네임 집합의 핫 패스를 따로 재는 마이크로 벤치마크
+// 벤치마크마다 한 번의 실행이 min_seconds 이상 걸리도록 연산 횟수를 늘려 가며 워밍업한 뒤, 같은 횟수로 repetitions번
+// 반복해 ns/op의 중앙값, 최솟값, 최댓값을 보고한다.
+
+struct BenchOpt
+{
+    std::string word_list_path;
+    std::string_view filter;
+    sz repetitions;
+    double min_seconds;
+};
+
+// 결과가 쓰이지 않는다고 보고 계산을 없애는 최적화를 막는다.
+template <typename T>
+void do_not_optimize(T const &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    auto const *volatile sink = &value;
+    static_cast<void>(sink);
+    _ReadWriteBarrier();
+#endif
+}
+
+// run(num_ops)는 num_ops번 이상의 연산을 실행하고 실제로 실행한 연산 수를 돌려준다.
+template <typename Run>
+void run_benchmark(BenchOpt const &opt, std::string_view const name, Run &&run)
+{
+    if (name.find(opt.filter) == std::string_view::npos)
+    {
+        return;
+    }
+    auto const measure = [&](sz const num_ops) {
+        auto const start = std::chrono::steady_clock::now();
+        auto const num_done = run(num_ops);
+        auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return std::pair(elapsed, num_done);
+    };
+
+    // 워밍업: 한 번의 실행이 min_seconds를 넘을 때까지 연산 횟수를 늘린다.
+    auto num_ops = sz(1);
+    while (true)
+    {
+        auto const [elapsed, num_done] = measure(num_ops);
+        if (opt.min_seconds <= elapsed)
+        {
+            num_ops = num_done;
+            break;
+        }
+        auto const scale = elapsed <= 0 ? 10.0 : std::clamp(opt.min_seconds * 1.2 / elapsed, 1.5, 10.0);
+        num_ops = static_cast<sz>(static_cast<double>(std::max(num_ops, num_done)) * scale);
+    }
+
+    auto ns_per_op = std::vector<double>();
+    for (auto i = sz(); i < opt.repetitions; ++i)
+    {
+        auto const [elapsed, num_done] = measure(num_ops);
+        ns_per_op.push_back(elapsed * 1e9 / static_cast<double>(num_done));
+    }
+    std::ranges::sort(ns_per_op);
+    auto const median = ns_per_op[ns_per_op.size() / 2];
+    spdlog::info("[{}] {:.2f} ns/op, {:.3f}M ops/s (최소 {:.2f}, 최대 {:.2f} ns/op, {}회 x {})", name, median,
+                 1e3 / median, ns_per_op.front(), ns_per_op.back(), opt.repetitions, num_ops);
+}
+
+template <typename RandomEngine>
+void bench_sampling(BenchOpt const &opt, std::string_view const engine_name, WordDB const &word_db)
+{
+    constexpr auto const &nickname_opt = SAMPLE_NICKNAME_OPT;
+    auto const name = [engine_name](std::string_view const bench) {
+        return std::string(bench) + "/" + std::string(engine_name);
+    };
+
+    auto random_engine = make_random_engine<RandomEngine>(0);
+    run_benchmark(opt, name("sample_ascii"), [&](sz const num_ops) {
+        auto symbols = SymbolDigits();
+        for (auto i = sz(); i < num_ops; ++i)
+        {
+            do_not_optimize(sample_ascii(random_engine, symbols));
+        }
+        return num_ops;
+    });
+    run_benchmark(opt, name("sample_word"), [&](sz const num_ops) {
+        for (auto i = sz(); i < num_ops; ++i)
+        {
+            do_not_optimize(
+                sample_word(random_engine, word_db, nickname_opt.min_word_len, nickname_opt.max_word_len).data());
+        }
+        return num_ops;
+    });
+    run_benchmark(opt, name("sample_and_mangle_word"), [&](sz const num_ops) {
+        auto symbols = SymbolDigits();
+        auto word = NicknameBuffer();
+        for (auto i = sz(); i < num_ops; ++i)
+        {
+            do_not_optimize(sample_and_mangle_word(random_engine, symbols, word_db, nickname_opt.min_word_len,
+                                                   nickname_opt.max_word_len, nickname_opt.mangling_factor,
+                                                   word.data()));
+            do_not_optimize(word);
+        }
+        return num_ops;
+    });
+    run_benchmark(opt, name("sample_nickname"), [&](sz const num_ops) {
+        for (auto i = sz(); i < num_ops; ++i)
+        {
+            do_not_optimize(sample_nickname_key(random_engine, word_db, nickname_opt));
+        }
+        return num_ops;
+    });
+    run_benchmark(opt, name("sample_nickname_plans"), [&](sz const num_ops) {
+        auto const plans = CompositionPlans(word_db, nickname_opt);
+        for (auto i = sz(); i < num_ops; ++i)
+        {
+            do_not_optimize(sample_nickname_key(random_engine, plans));
+        }
+        return num_ops;
+    });
+    run_benchmark(opt, name("sample_nickname_batch"), [&](sz const num_ops) {
+        auto const sampler = BatchNicknameSampler(word_db, nickname_opt);
+        auto keys = std::array<NicknameKey, BatchNicknameSampler::BATCH_SIZE>();
+        auto num_done = sz();
+        for (; num_done < num_ops; num_done += keys.size())
+        {
+            sampler.sample(random_engine, keys);
+            do_not_optimize(keys);
+        }
+        return num_done;
+    });
+
+    // RECREATE 모드처럼 닉네임마다 32비트 시드로 엔진을 새로 만든다.
+    run_benchmark(opt, name("sample_nickname_recreate"), [&](sz const num_ops) {
+        auto seeder = SplitMix64(1);
+        for (auto i = sz(); i < num_ops; ++i)
+        {
+            auto recreated = RandomEngine(static_cast<u32>(seeder()));
+            do_not_optimize(sample_nickname_key(recreated, word_db, nickname_opt));
+        }
+        return num_ops;
+    });
+}
+
+// 해시 집합의 성능은 키의 분포보다 해시 값에 좌우되므로, 닉네임을 생성하는 대신 임의의 60비트 키를 사용한다.
+std::vector<NicknameKey> make_random_keys(u64 const seed, sz const count)
+{
+    constexpr auto KEY_MASK = (static_cast<NicknameKey>(1) << (NICKNAME_SYMBOL_BITS * MAX_PACKED_NICKNAME_LEN)) - 1;
+    auto random_engine = SplitMix64(seed);
+    auto keys = std::vector<NicknameKey>(count);
+    for (auto &key : keys)
+    {
+        key = (random_engine() & KEY_MASK) | 1;
+    }
+    return keys;
+}
+
+// 크기가 population인 집합을 처음부터 채우는 삽입과, 절반은 집합에 있는 키로 하는 조회를 잰다.
+template <typename NicknameSet>
+void bench_nickname_set(BenchOpt const &opt, std::string_view const set_name, sz const population)
+{
+    constexpr static auto NUM_PROBE_KEYS = static_cast<sz>(1 << 20);
+    auto const name = [&](std::string_view const bench) {
+        return std::string(bench) + "/" + std::string(set_name) + "/" + std::to_string(population);
+    };
+
+    auto const keys = make_random_keys(1, population);
+    run_benchmark(opt, name("insert"), [&](sz const num_ops) {
+        auto num_done = sz();
+        while (num_done < num_ops)
+        {
+            auto nickname_db = NicknameSet(population);
+            for (auto const key : keys)
+            {
+                do_not_optimize(nickname_db.insert(key));
+            }
+            num_done += keys.size();
+        }
+        return num_done;
+    });
+
+    auto nickname_db = NicknameSet(population);
+    for (auto const key : keys)
+    {
+        nickname_db.insert(key);
+    }
+    auto probe_keys = make_random_keys(2, NUM_PROBE_KEYS);
+    for (auto i = sz(); i < probe_keys.size(); i += 2)
+    {
+        probe_keys[i] = keys[i % keys.size()];
+    }
+    std::ranges::shuffle(probe_keys, std::mt19937_64(3));
+
+    run_benchmark(opt, name("contains"), [&](sz const num_ops) {
+        auto num_done = sz();
+        for (; num_done < num_ops; num_done += probe_keys.size())
+        {
+            for (auto const key : probe_keys)
+            {
+                do_not_optimize(nickname_db.contains(key));
+            }
+        }
+        return num_done;
+    });
+    run_benchmark(opt, name("contains_batch"), [&](sz const num_ops) {
+        auto found = std::make_unique<bool[]>(probe_keys.size());
+        auto num_done = sz();
+        for (; num_done < num_ops; num_done += probe_keys.size())
+        {
+            nickname_db.contains_batch(probe_keys, found.get());
+            do_not_optimize(found[0]);
+        }
+        return num_done;
+    });
+}
+
+constexpr static auto USAGE = R"(usage: random-nickname-bench [options] [word-list]
+
+options:
+  --word-list PATH          word list file (default: external/wordlist/wordlist-20210729.txt)
+  --filter TEXT             run only the benchmarks whose name contains TEXT
+  --repetitions N           measured repetitions per benchmark (default: 5)
+  --min-time SECONDS        minimum duration of one repetition, also used for warmup (default: 0.2)
+  --help                    print this message
+)";
+
+BenchOpt parse_command_line(int const argc, char const *const argv[])
+{
+    auto opt = BenchOpt{get_wordlist_txt_path().string(), "", 5, 0.2};
+    for (auto args = CommandLine(argc, argv); !args.empty();)
+    {
+        auto const arg = args.next();
+        if (arg == "--help" || arg == "-h")
+        {
+            std::cout << USAGE;
+            std::exit(EXIT_SUCCESS);
+        }
+        else if (arg == "--word-list")
+        {
+            opt.word_list_path = std::string(args.value(arg));
+        }
+        else if (arg == "--filter")
+        {
+            opt.filter = args.value(arg);
+        }
+        else if (arg == "--repetitions")
+        {
+            opt.repetitions = parse_number<sz>(arg, args.value(arg));
+        }
+        else if (arg == "--min-time")
+        {
+            opt.min_seconds = parse_number<double>(arg, args.value(arg));
+        }
+        else if (arg.starts_with("--"))
+        {
+            throw std::invalid_argument("unknown option: " + std::string(arg));
+        }
+        else
+        {
+            opt.word_list_path = std::string(arg);
+        }
+    }
+    if (opt.repetitions == 0 || !(0 < opt.min_seconds))
+    {
+        throw std::invalid_argument("--repetitions and --min-time must be positive");
+    }
+    return opt;
+}
+
+int main(int const argc, char const *const argv[])
+{
+    auto opt = BenchOpt();
+    try
+    {
+        opt = parse_command_line(argc, argv);
+    }
+    catch (std::invalid_argument const &e)
+    {
+        spdlog::critical(e.what());
+        std::cerr << USAGE;
+        return EXIT_FAILURE;
+    }
+
+    auto const word_db = load_word_db(opt.word_list_path);
+
+    bench_sampling<std::mt19937>(opt, "mt19937", word_db);
+    bench_sampling<std::mt19937_64>(opt, "mt19937_64", word_db);
+    bench_sampling<LazyMt19937>(opt, "lazy_mt19937", word_db);
+    bench_sampling<LazyMt19937_64>(opt, "lazy_mt19937_64", word_db);
+    bench_sampling<SplitMix64>(opt, "splitmix64", word_db);
+    bench_sampling<Xoshiro256StarStar>(opt, "xoshiro256ss", word_db);
+    bench_sampling<Pcg64>(opt, "pcg64", word_db);
+    bench_sampling<Philox4x32>(opt, "philox4x32", word_db);
+
+    for (auto const population : {sz(10'000), sz(1'000'000), sz(10'000'000)})
+    {
+        bench_nickname_set<FlatNicknameSet>(opt, "flat", population);
+        bench_nickname_set<ConcurrentNicknameSet>(opt, "concurrent", population);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <span>
+
+#include "nickname_key.h"
+#include "prefetch.h"
+#include "types.h"
+
+// 키마다 하나의 캐시 라인(512비트 블록) 안의 비트들만 사용하는 Bloom filter
+// 조회 한 번에 캐시 미스가 최대 한 번이므로, 집합보다 훨씬 작은 이 필터로 대부분의 미스를 걸러낸다.
+// 비트는 relaxed fetch_or로 설정하므로 여러 스레드가 동시에 insert와 might_contain을 호출할 수 있다.
+class BlockedBloomFilter
+{
+  public:
+    constexpr static auto BLOCK_BITS = static_cast<sz>(512);
+
+    BlockedBloomFilter(sz const expected_size, double const bits_per_key)
+        : num_blocks_(std::max(static_cast<sz>(1),
+                               static_cast<sz>(std::ceil(static_cast<double>(expected_size) * bits_per_key / BLOCK_BITS)))),
+          num_probes_(std::clamp(static_cast<sz>(std::round(bits_per_key * std::log(2.0))), static_cast<sz>(1),
+                                 static_cast<sz>(16))),
+          blocks_(std::make_unique<Block[]>(num_blocks_))
+    {
+    }
+
+    // ConcurrentNicknameSet의 복사 생성자와 같이, 복사하는 동안 other에 insert를 호출해서는 안 된다.
+    BlockedBloomFilter(BlockedBloomFilter const &other)
+        : num_blocks_(other.num_blocks_), num_probes_(other.num_probes_),
+          blocks_(std::make_unique<Block[]>(num_blocks_))
+    {
+        for (auto i = sz(); i < num_blocks_; ++i)
+        {
+            for (auto j = sz(); j < BLOCK_BITS / 64; ++j)
+            {
+                blocks_[i].words[j].store(other.blocks_[i].words[j].load(std::memory_order_relaxed),
+                                          std::memory_order_relaxed);
+            }
+        }
+    }
+
+    BlockedBloomFilter(BlockedBloomFilter &&) noexcept = default;
+    BlockedBloomFilter &operator=(BlockedBloomFilter &&) noexcept = default;
+
+    void insert(NicknameKey const key) noexcept
+    {
+        auto const hash = hash_nickname_key(key);
+        auto &block = blocks_[block_index(hash)];
+        for_each_bit(hash, [&](sz const bit) {
+            block.words[bit / 64].fetch_or(u64(1) << (bit % 64), std::memory_order_relaxed);
+            return true;
+        });
+    }
+
+    bool might_contain(NicknameKey const key) const noexcept
+    {
+        auto const hash = hash_nickname_key(key);
+        auto const &block = blocks_[block_index(hash)];
+        return for_each_bit(hash, [&](sz const bit) {
+            return (block.words[bit / 64].load(std::memory_order_relaxed) >> (bit % 64) & 1) != 0;
+        });
+    }
+
+    // FlatNicknameSet::contains_batch처럼 PREFETCH_BATCH_SIZE개씩 블록을 먼저 프리페치한 뒤 검사한다.
+    void might_contain_batch(std::span<NicknameKey const> const keys, bool *const found) const noexcept
+    {
+        auto hashes = std::array<u64, PREFETCH_BATCH_SIZE>();
+        for (auto begin = sz(); begin < keys.size(); begin += PREFETCH_BATCH_SIZE)
+        {
+            auto const count = std::min(PREFETCH_BATCH_SIZE, keys.size() - begin);
+            for (auto i = sz(); i < count; ++i)
+            {
+                hashes[i] = hash_nickname_key(keys[begin + i]);
+                prefetch_read(&blocks_[block_index(hashes[i])]);
+            }
+            for (auto i = sz(); i < count; ++i)
+            {
+                auto const &block = blocks_[block_index(hashes[i])];
+                found[begin + i] = for_each_bit(hashes[i], [&](sz const bit) {
+                    return (block.words[bit / 64].load(std::memory_order_relaxed) >> (bit % 64) & 1) != 0;
+                });
+            }
+        }
+    }
+
+    sz num_probes() const noexcept
+    {
+        return num_probes_;
+    }
+
+    sz memory_usage() const noexcept
+    {
+        return num_blocks_ * sizeof(Block);
+    }
+
+  private:
+    struct alignas(64) Block
+    {
+        std::atomic<u64> words[BLOCK_BITS / 64];
+    };
+
+    // 집합은 해시의 하위 비트로 슬롯을 고르므로, 블록은 상위 32비트로 고른다.
+    sz block_index(u64 const hash) const noexcept
+    {
+        return static_cast<sz>((hash >> 32) * num_blocks_ >> 32);
+    }
+
+    // 블록 안의 위치는 하위 32비트에서 얻은 두 값으로 double hashing한다. fn이 false를 돌려주면 멈춘다.
+    template <typename Fn>
+    bool for_each_bit(u64 const hash, Fn &&fn) const noexcept
+    {
+        auto const low = static_cast<u32>(hash);
+        auto bit = static_cast<sz>(low % BLOCK_BITS);
+        auto const step = static_cast<sz>((low >> 9) | 1);
+        for (auto i = sz(); i < num_probes_; ++i, bit = (bit + step) % BLOCK_BITS)
+        {
+            if (!fn(bit))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    sz num_blocks_;
+    sz num_probes_;
+    std::unique_ptr<Block[]> blocks_;
+};
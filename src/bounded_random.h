@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "random_engines.h"
+#include "types.h"
+
+// 엔진의 출력을 균등한 64비트 난수로 변환한다. 32비트 엔진은 두 번의 출력을 이어 붙인다.
+template <typename RandomEngine>
+u64 random_bits(RandomEngine &random_engine)
+{
+    constexpr auto range = static_cast<u64>(RandomEngine::max() - RandomEngine::min());
+    if constexpr (range == std::numeric_limits<u64>::max())
+    {
+        return static_cast<u64>(random_engine() - RandomEngine::min());
+    }
+    else if constexpr (range == std::numeric_limits<u32>::max())
+    {
+        auto const hi = static_cast<u64>(random_engine() - RandomEngine::min());
+        return (hi << 32) | static_cast<u64>(random_engine() - RandomEngine::min());
+    }
+    else
+    {
+        return std::uniform_int_distribution<u64>()(random_engine);
+    }
+}
+
+// [0, range) 범위의 균등한 정수를 반환한다. range는 0보다 커야 한다.
+// Lemire, "Fast Random Integer Generation in an Interval" (2019)의 방식으로, 대부분의 경우 나눗셈 없이 곱셈 한 번으로 끝난다.
+// 32비트 엔진은 range가 2^32 이하라면 출력 하나만 사용한다.
+template <typename RandomEngine>
+u64 bounded_random(RandomEngine &random_engine, u64 const range)
+{
+    constexpr auto engine_range = static_cast<u64>(RandomEngine::max() - RandomEngine::min());
+    if constexpr (engine_range == std::numeric_limits<u32>::max())
+    {
+        if (range <= engine_range + 1)
+        {
+            auto const draw = [&random_engine, range]() {
+                return static_cast<u64>(random_engine() - RandomEngine::min()) * range;
+            };
+            auto m = draw();
+            if (static_cast<u32>(m) < range)
+            {
+                auto const threshold = static_cast<u32>(-static_cast<u32>(range) % static_cast<u32>(range));
+                while (static_cast<u32>(m) < threshold)
+                {
+                    m = draw();
+                }
+            }
+            return m >> 32;
+        }
+    }
+
+    auto m = mul_64x64_128(random_bits(random_engine), range);
+    if (m.first < range)
+    {
+        auto const threshold = -range % range;
+        while (m.first < threshold)
+        {
+            m = mul_64x64_128(random_bits(random_engine), range);
+        }
+    }
+    return m.second;
+}
+
+// 64비트 난수 하나에서 균등한 [0, RADIX) 숫자를 여러 개 꺼낸다.
+// RADIX^k 이상인 난수를 거절하면 남은 값은 k자리 RADIX진수로서 균등하므로, 각 자리가 서로 독립인 균등 난수가 된다.
+// k는 난수 하나당 기대되는 숫자의 개수 k * (1 - 거절 확률)가 가장 큰 값으로 정한다.
+template <u64 RADIX>
+class RandomDigits
+{
+  public:
+    template <typename RandomEngine>
+    u64 next(RandomEngine &random_engine)
+    {
+        if (num_digits_ == 0)
+        {
+            auto bits = random_bits(random_engine);
+            while (LIMIT <= bits)
+            {
+                bits = random_bits(random_engine);
+            }
+            value_ = bits % MODULUS;
+            num_digits_ = DIGITS_PER_DRAW;
+        }
+        --num_digits_;
+        auto const digit = value_ % RADIX;
+        value_ /= RADIX;
+        return digit;
+    }
+
+  private:
+    struct Layout
+    {
+        sz digits;
+        u64 modulus;
+        u64 limit;
+    };
+
+    constexpr static Layout best_layout() noexcept
+    {
+        auto best = Layout{1, RADIX, RADIX * (std::numeric_limits<u64>::max() / RADIX)};
+        auto best_yield = 0.0;
+        auto modulus = RADIX;
+        for (auto digits = static_cast<sz>(1);; ++digits)
+        {
+            auto const limit = modulus * (std::numeric_limits<u64>::max() / modulus);
+            auto const yield = static_cast<double>(digits) * static_cast<double>(limit) /
+                               static_cast<double>(std::numeric_limits<u64>::max());
+            if (best_yield < yield)
+            {
+                best = Layout{digits, modulus, limit};
+                best_yield = yield;
+            }
+            if (std::numeric_limits<u64>::max() / RADIX < modulus)
+            {
+                return best;
+            }
+            modulus *= RADIX;
+        }
+    }
+
+    constexpr static auto DIGITS_PER_DRAW = best_layout().digits;
+    constexpr static auto MODULUS = best_layout().modulus;
+    constexpr static auto LIMIT = best_layout().limit;
+
+    u64 value_ = 0;
+    sz num_digits_ = 0;
+};
+
+// std::shuffle과 같은 Fisher-Yates 셔플이지만 bounded_random을 사용한다.
+template <typename RandomEngine, typename T>
+void shuffle(RandomEngine &random_engine, std::span<T> const items)
+{
+    for (auto i = items.size(); 1 < i; --i)
+    {
+        std::swap(items[i - 1], items[bounded_random(random_engine, i)]);
+    }
+}
+
+// Walker의 별칭 방법으로 [0, n)의 정수 i를 weights[i]에 비례하는 확률로 상수 시간에 뽑는다.
+// 64비트 난수 r 하나로 r * n의 상위 64비트를 열로, 하위 64비트를 임계값과 비교할 값으로 쓴다. 하위 값은 간격이 n인
+// 격자 위에 놓이므로 각 확률의 오차는 n / 2^64 이하이며, 가중치를 double로 나타내는 오차와 같은 정도이다.
+class AliasTable
+{
+  public:
+    AliasTable() = default;
+
+    explicit AliasTable(std::vector<double> const &weights) : entries_(weights.size())
+    {
+        auto const total = std::accumulate(weights.begin(), weights.end(), 0.0);
+        auto scaled = std::vector<double>(weights.size());
+        auto small = std::vector<u32>();
+        auto large = std::vector<u32>();
+        for (auto i = sz(); i < weights.size(); ++i)
+        {
+            scaled[i] = weights[i] * static_cast<double>(weights.size()) / total;
+            entries_[i] = Entry{std::numeric_limits<u64>::max(), static_cast<u32>(i)};
+            (scaled[i] < 1 ? small : large).push_back(static_cast<u32>(i));
+        }
+        // 짝을 찾지 못하고 남은 열은 반올림 오차를 제외하면 확률이 1이므로 초기값을 그대로 둔다.
+        while (!small.empty() && !large.empty())
+        {
+            auto const less = small.back();
+            auto const more = large.back();
+            small.pop_back();
+            entries_[less] = Entry{to_threshold(scaled[less]), more};
+            scaled[more] -= 1 - scaled[less];
+            if (scaled[more] < 1)
+            {
+                large.pop_back();
+                small.push_back(more);
+            }
+        }
+    }
+
+    sz size() const noexcept
+    {
+        return entries_.size();
+    }
+
+    template <typename RandomEngine>
+    sz operator()(RandomEngine &random_engine) const
+    {
+        auto const [low, column] = mul_64x64_128(random_bits(random_engine), entries_.size());
+        auto const &entry = entries_[column];
+        // 어느 쪽이 선택될지 예측할 수 없으므로 분기 대신 마스크로 고른다.
+        auto const keep = static_cast<sz>(0) - static_cast<sz>(low < entry.threshold);
+        return (static_cast<sz>(column) & keep) | (static_cast<sz>(entry.alias) & ~keep);
+    }
+
+  private:
+    struct Entry
+    {
+        u64 threshold;
+        u32 alias;
+    };
+
+    // 열을 그대로 사용할 확률 p를 64비트 값과 비교할 임계값 p * 2^64로 바꾼다.
+    static u64 to_threshold(double const p) noexcept
+    {
+        constexpr auto TWO_POW_64 = 18446744073709551616.0;
+        constexpr auto MAX_BELOW_TWO_POW_64 = 18446744073709549568.0;
+        return p <= 0 ? 0 : static_cast<u64>(std::min(p * TWO_POW_64, MAX_BELOW_TWO_POW_64));
+    }
+
+    std::vector<Entry> entries_;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "types.h"
+
+// 명령행 인자를 앞에서부터 하나씩 읽는다. 잘못된 인자는 std::invalid_argument로 보고된다.
+class CommandLine
+{
+  public:
+    CommandLine(int const argc, char const *const argv[]) : args_(argv + 1, argv + argc)
+    {
+    }
+
+    bool empty() const noexcept
+    {
+        return args_.size() <= pos_;
+    }
+
+    std::string_view next() noexcept
+    {
+        return args_[pos_++];
+    }
+
+    std::string_view value(std::string_view const name)
+    {
+        if (empty())
+        {
+            throw std::invalid_argument("missing value for " + std::string(name));
+        }
+        return next();
+    }
+
+  private:
+    std::vector<std::string_view> args_;
+    sz pos_ = 0;
+};
+
+inline std::vector<std::string_view> split_list(std::string_view value)
+{
+    auto items = std::vector<std::string_view>();
+    for (auto pos = value.find(','); pos != std::string_view::npos; pos = value.find(','))
+    {
+        items.push_back(value.substr(0, pos));
+        value.remove_prefix(pos + 1);
+    }
+    items.push_back(value);
+    return items;
+}
+
+template <typename T>
+T parse_number(std::string_view const name, std::string_view const value)
+{
+    auto result = T();
+    auto const [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (ec != std::errc() || ptr != value.data() + value.size())
+    {
+        throw std::invalid_argument("invalid value for " + std::string(name) + ": " + std::string(value));
+    }
+    return result;
+}
+
+template <typename T>
+std::vector<T> parse_number_list(std::string_view const name, std::string_view const value)
+{
+    auto numbers = std::vector<T>();
+    for (auto const item : split_list(value))
+    {
+        numbers.push_back(parse_number<T>(name, item));
+    }
+    return numbers;
+}
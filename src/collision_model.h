@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "composition_plan.h"
+#include "nickname_key.h"
+#include "parallel.h"
+#include "sample_nickname_opt.h"
+#include "types.h"
+#include "word_db.h"
+
+// sample_nickname이 만드는 닉네임 분포의 충돌 확률 sum p(x)^2를 표본 추출 없이 계산한다.
+//
+// 닉네임은 조각들을 섞어 이어 붙인 것이고, 각 조각의 내용은 조각의 종류(단어, 채움 문자열)와 길이에만 의존한다.
+// 두 닉네임이 같은 조각들을 같은 순서로 가질 확률은 조각 모양의 다중집합 H마다
+//     B(H)^2 * (prod m_i!) / k! * prod S(h)
+// 의 합이다. B(H)는 생성 과정에서 H가 나올 확률, k는 조각 수, m_i는 H에서 같은 모양의 개수, S(h)는 모양이 h인 조각
+// 둘이 같을 확률이다. 서로 다른 조각 구성이 우연히 같은 문자열이 되는 경우는 세지 않으므로 이 값은 실제 충돌 확률의
+// 하한이지만, 단어 조각은 대문자로 시작하므로 그런 경우는 드물다.
+
+// RECREATE 모드는 닉네임마다 32비트 시드로 엔진을 만들기 때문에, 두 닉네임의 시드가 같을 확률만큼 충돌이 늘어난다.
+constexpr static auto RECREATE_SEED_BITS = 32;
+
+// 채움 문자열은 소문자 하나와 NICKNAME_SYMBOLS에서 균등하게 뽑은 len - 1개의 문자로 이루어진다.
+inline double filler_piece_collision_probability(sz const len) noexcept
+{
+    return 1.0 / 26 * std::pow(1.0 / static_cast<double>(NICKNAME_SYMBOLS.length()), static_cast<double>(len - 1));
+}
+
+// 길이가 len인 단어 조각 둘이 같을 확률
+// 두 조각의 변형 위치 집합 (T, T')마다, 둘 다 변형되지 않은 위치 U에서 단어가 일치해야 한다. 따라서 U에 대한 사영이
+// 같은 단어끼리 묶으면, 한쪽만 변형된 위치에서 변형된 문자가 다른 쪽의 원래 문자와 같을 확률의 곱을 묶음마다 더해
+// 단어 쌍을 모두 비교하지 않고도 계산할 수 있다.
+inline double word_piece_collision_probability(WordDB const &word_db, sz const len, double const mangling_factor,
+                                               sz const num_threads)
+{
+    auto const num_words = word_db.num_words(len);
+    if (num_words == 0)
+    {
+        return 0.0;
+    }
+    auto const num_mangled = num_mangled_chars(len, mangling_factor);
+
+    // 첫 글자는 대문자로 바뀌므로 대문자로 비교한다. 변형된 첫 글자는 균등한 대문자이고,
+    // 변형된 나머지 글자는 sample_ascii_folded의 분포(숫자 1/62, 소문자 2/62)를 따른다.
+    auto const symbol_prob = 1.0 / static_cast<double>(NICKNAME_SYMBOLS.length());
+    auto const canonical = [](char const ch, sz const pos) {
+        return pos == 0 && 'a' <= ch && ch <= 'z' ? static_cast<char>(ch - 'a' + 'A') : ch;
+    };
+    auto const mangled_prob = [&](char const ch, sz const pos) {
+        if (pos == 0)
+        {
+            return 'A' <= ch && ch <= 'Z' ? 1.0 / 26 : 0.0;
+        }
+        if ('0' <= ch && ch <= '9')
+        {
+            return symbol_prob;
+        }
+        return 'a' <= ch && ch <= 'z' ? 2 * symbol_prob : 0.0;
+    };
+    auto const both_mangled_prob = [&](sz const pos) {
+        return pos == 0 ? 1.0 / 26 : 10 * symbol_prob * symbol_prob + 26 * (2 * symbol_prob) * (2 * symbol_prob);
+    };
+
+    auto const first = word_db.first_index[len];
+    auto chars = std::vector<char>(num_words * len);
+    auto probs = std::vector<double>(num_words * len);
+    for (auto w = sz(); w < num_words; ++w)
+    {
+        auto const word = word_db.word(first + w);
+        for (auto pos = sz(); pos < len; ++pos)
+        {
+            chars[w * len + pos] = canonical(word[pos], pos);
+            probs[w * len + pos] = mangled_prob(chars[w * len + pos], pos);
+        }
+    }
+
+    // 변형 위치 집합의 쌍을 변형되지 않은 공통 위치 U별로 묶는다.
+    auto const full = (static_cast<u32>(1) << len) - 1;
+    auto subsets = std::vector<u32>();
+    for (auto mask = u32(); mask <= full; ++mask)
+    {
+        if (static_cast<sz>(std::popcount(mask)) == num_mangled)
+        {
+            subsets.push_back(mask);
+        }
+    }
+    auto pairs_by_unmangled = std::map<u32, std::vector<std::pair<u32, u32>>>();
+    for (auto const t1 : subsets)
+    {
+        for (auto const t2 : subsets)
+        {
+            pairs_by_unmangled[full & ~(t1 | t2)].emplace_back(t1, t2);
+        }
+    }
+    auto groups = std::vector<std::pair<u32, std::vector<std::pair<u32, u32>>>>(
+        std::make_move_iterator(pairs_by_unmangled.begin()), std::make_move_iterator(pairs_by_unmangled.end()));
+
+    auto sums = std::vector<double>(groups.size());
+    parallel_for(num_threads, groups.size(), [&](sz const group, sz) {
+        auto const &[unmangled, pairs] = groups[group];
+
+        // U 위치의 문자로 단어를 정렬해, 사영이 같은 단어들이 연속하게 한다.
+        auto keys = std::vector<std::pair<std::array<char, MAX_NICKNAME_LEN>, u32>>(num_words);
+        for (auto w = sz(); w < num_words; ++w)
+        {
+            auto &key = keys[w].first;
+            for (auto pos = sz(); pos < len; ++pos)
+            {
+                key[pos] = (unmangled >> pos & 1) != 0 ? chars[w * len + pos] : '\0';
+            }
+            keys[w].second = static_cast<u32>(w);
+        }
+        std::ranges::sort(keys);
+
+        auto sum = 0.0;
+        for (auto const &[t1, t2] : pairs)
+        {
+            auto both = 1.0;
+            for (auto pos = sz(); pos < len; ++pos)
+            {
+                if ((t1 & t2) >> pos & 1)
+                {
+                    both *= both_mangled_prob(pos);
+                }
+            }
+            auto const product = [&](u32 const word, u32 const mask) {
+                auto result = 1.0;
+                for (auto pos = sz(); pos < len; ++pos)
+                {
+                    if ((mask >> pos & 1) != 0)
+                    {
+                        result *= probs[word * len + pos];
+                    }
+                }
+                return result;
+            };
+
+            // 묶음마다 (T'만 변형된 위치에서 첫 번째 단어가 맞을 확률의 합) * (T만 변형된 위치에서 두 번째 단어가 맞을
+            // 확률의 합)을 더한다.
+            auto pair_sum = 0.0;
+            for (auto begin = sz(); begin < keys.size();)
+            {
+                auto end = begin;
+                auto a = 0.0;
+                auto b = 0.0;
+                for (; end < keys.size() && keys[end].first == keys[begin].first; ++end)
+                {
+                    a += product(keys[end].second, t2 & ~t1);
+                    b += product(keys[end].second, t1 & ~t2);
+                }
+                pair_sum += a * b;
+                begin = end;
+            }
+            sum += both * pair_sum;
+        }
+        sums[group] = sum;
+    });
+
+    auto const num_subsets = static_cast<double>(subsets.size());
+    auto const n = static_cast<double>(num_words);
+    return std::accumulate(sums.begin(), sums.end(), 0.0) / (n * n * num_subsets * num_subsets);
+}
+
+// sample_nickname이 만드는 닉네임의 충돌 확률 sum p(x)^2 (위의 설명 참고)
+inline double nickname_collision_probability(WordDB const &word_db, SampleNicknameOpt const &opt,
+                                             sz const num_threads)
+{
+    // 조각의 모양은 (종류, 길이)이며, 단어 조각은 종류가 0, 채움 문자열은 1이다.
+    using PieceShape = std::pair<sz, sz>;
+
+    auto word_probs = std::array<double, MAX_NICKNAME_LEN + 1>();
+    for (auto len = opt.min_word_len; len <= std::min(opt.max_word_len, opt.max_len); ++len)
+    {
+        word_probs[len] = word_piece_collision_probability(word_db, len, opt.mangling_factor, num_threads);
+    }
+
+    // 구성 계획의 조각 모양을 정렬해 다중집합별 확률 B(H)를 구한다.
+    auto shape_probs = std::map<std::vector<PieceShape>, double>();
+    auto const plans = CompositionPlans(word_db, opt);
+    for (auto i = sz(); i < plans.plans().size(); ++i)
+    {
+        auto const &plan = plans.plans()[i];
+        auto shape = std::vector<PieceShape>();
+        for (auto j = sz(); j < plan.num_words; ++j)
+        {
+            shape.emplace_back(0, plan.word_lens[j]);
+        }
+        if (0 < plan.filler_len)
+        {
+            shape.emplace_back(1, plan.filler_len);
+        }
+        std::ranges::sort(shape);
+        shape_probs[shape] += plans.probabilities()[i];
+    }
+
+    auto result = 0.0;
+    for (auto const &[shape, prob] : shape_probs)
+    {
+        auto term = prob * prob;
+        for (auto i = sz(); i < shape.size(); ++i)
+        {
+            term *= shape[i].first == 0 ? word_probs[shape[i].second] : filler_piece_collision_probability(shape[i].second);
+        }
+        // 섞은 순서가 같을 확률: 같은 모양끼리 자리를 바꾼 순서는 구별되지 않으므로 prod m_i! / k!이다.
+        for (auto begin = sz(), rank = sz(); begin < shape.size(); ++begin)
+        {
+            rank = 0 < begin && shape[begin] == shape[begin - 1] ? rank + 1 : 1;
+            term *= static_cast<double>(rank) / static_cast<double>(begin + 1);
+        }
+        result += term;
+    }
+    return result;
+}
+
+// 충돌 확률이 collision_probability인 분포에서 뽑은 닉네임 num_initial_nicknames개 중 하나와 새 닉네임이 같을 확률
+// 사전 생성 닉네임마다 독립적으로 충돌한다고 보면 1 - (1 - p)^N이다. N * p는 N * p가 작을 때만 맞고 1을 넘을 수도
+// 있으므로 쓰지 않는다. 확률이 높은 닉네임은 사전 생성 닉네임끼리도 겹치므로 이 값도 근사다.
+inline double population_collision_probability(double const collision_probability,
+                                               sz const num_initial_nicknames) noexcept
+{
+    return -std::expm1(static_cast<double>(num_initial_nicknames) * std::log1p(-collision_probability));
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "bounded_random.h"
+#include "nickname_key.h"
+#include "sample_nickname_opt.h"
+#include "types.h"
+#include "word_db.h"
+
+// sample_nickname이 생성 과정에서 정하는 조각 길이의 순서. 단어 조각 뒤에 길이가 filler_len인 채움 문자열이 온다.
+struct CompositionPlan
+{
+    std::array<u8, MAX_PACKED_NICKNAME_LEN> word_lens;
+    u8 num_words;
+    u8 filler_len;
+};
+
+// 길이가 같은 단어들은 chars에 연속해 있으므로, 길이별 시작 위치만 알면 offsets를 읽지 않고 단어를 찾을 수 있다.
+struct WordBucket
+{
+    char const *chars;
+    sz num_words;
+};
+
+// 옵션과 단어 목록으로 정해지는 모든 구성 계획과 그 확률
+// 생성 과정에서 남은 길이가 chance일 때 단어의 길이는 [min_word_len, min(max_word_len, chance)] 범위의 단어 수에
+// 비례하는 확률로 정해지고, 단어는 그 길이의 단어 중에서 균등하게 뽑힌다. 따라서 계획을 그 확률로 먼저 뽑은 뒤 길이마다
+// 단어를 균등하게 뽑으면 sample_nickname과 같은 분포를 얻는다.
+class CompositionPlans
+{
+  public:
+    CompositionPlans(WordDB const &word_db, SampleNicknameOpt const &opt) : opt_(opt)
+    {
+        auto plan = CompositionPlan();
+        auto const walk = [&](auto const &self, sz const chance, double const prob) -> void {
+            if (chance < opt.min_word_len)
+            {
+                plan.filler_len = static_cast<u8>(chance);
+                plans_.push_back(plan);
+                probabilities_.push_back(prob);
+                return;
+            }
+            auto const max_word_len = std::min(opt.max_word_len, chance);
+            auto const num_words = word_db.num_words(opt.min_word_len, max_word_len);
+            if (num_words == 0)
+            {
+                constexpr auto msg = "there are no words to sample";
+                spdlog::critical(msg);
+                throw std::runtime_error(msg);
+            }
+            for (auto len = opt.min_word_len; len <= max_word_len; ++len)
+            {
+                if (word_db.num_words(len) != 0)
+                {
+                    plan.word_lens[plan.num_words++] = static_cast<u8>(len);
+                    self(self, chance - len,
+                         prob * static_cast<double>(word_db.num_words(len)) / static_cast<double>(num_words));
+                    --plan.num_words;
+                }
+            }
+        };
+        auto const num_lengths = static_cast<double>(opt.max_len - opt.min_len + 1);
+        for (auto len = opt.min_len; len <= opt.max_len; ++len)
+        {
+            walk(walk, len, 1.0 / num_lengths);
+        }
+        alias_table_ = AliasTable(probabilities_);
+
+        for (auto len = sz(); len < mangled_chars_.size(); ++len)
+        {
+            mangled_chars_[len] = num_mangled_chars(len, opt.mangling_factor);
+            word_buckets_[len] = WordBucket{word_db.chars.data() + word_db.offsets[word_db.first_index[len]],
+                                           word_db.num_words(len)};
+        }
+    }
+
+    SampleNicknameOpt const &opt() const noexcept
+    {
+        return opt_;
+    }
+
+    std::vector<CompositionPlan> const &plans() const noexcept
+    {
+        return plans_;
+    }
+
+    std::vector<double> const &probabilities() const noexcept
+    {
+        return probabilities_;
+    }
+
+    // 길이가 len인 단어에서 변형되는 문자의 수
+    sz mangled_chars(sz const len) const noexcept
+    {
+        return mangled_chars_[len];
+    }
+
+    // 길이가 len인 단어의 목록
+    WordBucket const &word_bucket(sz const len) const noexcept
+    {
+        return word_buckets_[len];
+    }
+
+    template <typename RandomEngine>
+    CompositionPlan const &sample(RandomEngine &random_engine) const
+    {
+        return plans_[alias_table_(random_engine)];
+    }
+
+  private:
+    SampleNicknameOpt opt_;
+    std::vector<CompositionPlan> plans_;
+    std::vector<double> probabilities_;
+    AliasTable alias_table_;
+    std::array<sz, MAX_NICKNAME_LEN + 1> mangled_chars_{};
+    std::array<WordBucket, MAX_NICKNAME_LEN + 1> word_buckets_{};
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <span>
+#include <stdexcept>
+
+#include "nickname_key.h"
+#include "prefetch.h"
+#include "types.h"
+
+// 삽입만 가능한 고정 용량의 lock-free 해시 셋
+// 빈 슬롯(EMPTY_NICKNAME_KEY)을 CAS로 선점하는 linear probing을 사용하므로 여러 스레드가 동시에 insert와 contains를
+// 호출할 수 있다. 키 자체가 저장되는 값의 전부이므로 슬롯 접근에는 relaxed 순서로 충분하다.
+// 원소 수는 경합을 줄이기 위해 슬롯 위치에 따라 나뉜 카운터들의 합으로 관리한다.
+class ConcurrentNicknameSet
+{
+  public:
+    constexpr static auto MAX_LOAD_FACTOR = 0.75;
+
+    explicit ConcurrentNicknameSet(sz const expected_size)
+        : capacity_(std::bit_ceil(static_cast<sz>(expected_size / MAX_LOAD_FACTOR) + 1)), mask_(capacity_ - 1),
+          slots_(std::make_unique<std::atomic<NicknameKey>[]>(capacity_))
+    {
+    }
+
+    // other와 같은 원소를 가진 집합을 만든다. 복사하는 동안 other에 insert를 호출해서는 안 된다.
+    // 슬롯은 복사하는 스레드가 처음 쓰므로, first-touch 정책에서는 그 스레드의 NUMA 노드에 놓인다.
+    ConcurrentNicknameSet(ConcurrentNicknameSet const &other)
+        : capacity_(other.capacity_), mask_(other.mask_),
+          slots_(std::make_unique<std::atomic<NicknameKey>[]>(capacity_))
+    {
+        for (auto idx = sz(); idx < capacity_; ++idx)
+        {
+            slots_[idx].store(other.slots_[idx].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        for (auto i = sz(); i < NUM_COUNTERS; ++i)
+        {
+            counters_[i].value.store(other.counters_[i].value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    ConcurrentNicknameSet &operator=(ConcurrentNicknameSet const &) = delete;
+
+    // 새로 삽입되었다면 true를 반환한다. 빈 슬롯이 남아 있지 않다면 std::length_error를 던진다.
+    bool insert(NicknameKey const key)
+    {
+        auto idx = hash_nickname_key(key) & mask_;
+        for (auto num_probes = sz(); num_probes < capacity_; ++num_probes, idx = (idx + 1) & mask_)
+        {
+            auto current = slots_[idx].load(std::memory_order_relaxed);
+            if (current == EMPTY_NICKNAME_KEY &&
+                slots_[idx].compare_exchange_strong(current, key, std::memory_order_relaxed))
+            {
+                counters_[idx & (NUM_COUNTERS - 1)].value.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (current == key)
+            {
+                return false;
+            }
+        }
+        throw std::length_error("concurrent nickname set is full");
+    }
+
+    bool contains(NicknameKey const key) const noexcept
+    {
+        return contains_from(key, hash_nickname_key(key) & mask_);
+    }
+
+    // FlatNicknameSet::contains_batch와 같다.
+    void contains_batch(std::span<NicknameKey const> const keys, bool *const found) const noexcept
+    {
+        auto indices = std::array<sz, PREFETCH_BATCH_SIZE>();
+        for (auto begin = sz(); begin < keys.size(); begin += PREFETCH_BATCH_SIZE)
+        {
+            auto const count = std::min(PREFETCH_BATCH_SIZE, keys.size() - begin);
+            for (auto i = sz(); i < count; ++i)
+            {
+                indices[i] = hash_nickname_key(keys[begin + i]) & mask_;
+                prefetch_read(&slots_[indices[i]]);
+            }
+            for (auto i = sz(); i < count; ++i)
+            {
+                found[begin + i] = contains_from(keys[begin + i], indices[i]);
+            }
+        }
+    }
+
+    sz size() const noexcept
+    {
+        auto size = sz();
+        for (auto const &counter : counters_)
+        {
+            size += counter.value.load(std::memory_order_relaxed);
+        }
+        return size;
+    }
+
+    sz capacity() const noexcept
+    {
+        return capacity_;
+    }
+
+    double load_factor() const noexcept
+    {
+        return static_cast<double>(size()) / static_cast<double>(capacity_);
+    }
+
+    sz memory_usage() const noexcept
+    {
+        return capacity_ * sizeof(NicknameKey);
+    }
+
+  private:
+    constexpr static auto NUM_COUNTERS = static_cast<sz>(64);
+
+    bool contains_from(NicknameKey const key, sz idx) const noexcept
+    {
+        for (auto num_probes = sz(); num_probes < capacity_; ++num_probes, idx = (idx + 1) & mask_)
+        {
+            auto const current = slots_[idx].load(std::memory_order_relaxed);
+            if (current == key)
+            {
+                return true;
+            }
+            if (current == EMPTY_NICKNAME_KEY)
+            {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    struct alignas(64) Counter
+    {
+        std::atomic<sz> value = 0;
+    };
+
+    sz capacity_;
+    sz mask_;
+    std::unique_ptr<std::atomic<NicknameKey>[]> slots_;
+    Counter counters_[NUM_COUNTERS];
+};
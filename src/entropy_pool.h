@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <bcrypt.h>
+#pragma comment(lib, "bcrypt")
+#elif defined(__linux__)
+#include <cerrno>
+#include <sys/random.h>
+#endif
+
+#include "types.h"
+
+// 운영체제의 난수 소스에서 한 번에 POOL_SIZE개의 32비트 값을 읽어 두고 하나씩 꺼내 주는 시드 공급원
+// std::random_device를 대신해 닉네임마다 새로운 시드를 얻을 때 시스템 호출 횟수를 POOL_SIZE분의 1로 줄인다.
+class EntropyPool
+{
+  public:
+    using result_type = u32;
+
+    constexpr static auto POOL_SIZE = static_cast<sz>(4096);
+
+    constexpr static result_type min() noexcept
+    {
+        return std::numeric_limits<result_type>::min();
+    }
+
+    constexpr static result_type max() noexcept
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()()
+    {
+        if (pos_ == pool_.size())
+        {
+            refill();
+            pos_ = 0;
+        }
+        return pool_[pos_++];
+    }
+
+  private:
+    void refill()
+    {
+#if defined(_WIN32)
+        if (!BCRYPT_SUCCESS(BCryptGenRandom(nullptr, reinterpret_cast<PUCHAR>(pool_.data()),
+                                            static_cast<ULONG>(sizeof(pool_)), BCRYPT_USE_SYSTEM_PREFERRED_RNG)))
+        {
+            throw std::runtime_error("BCryptGenRandom failed");
+        }
+#elif defined(__linux__)
+        auto *const bytes = reinterpret_cast<char *>(pool_.data());
+        for (auto filled = sz(); filled < sizeof(pool_);)
+        {
+            auto const result = getrandom(bytes + filled, sizeof(pool_) - filled, 0);
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::runtime_error("getrandom failed");
+            }
+            filled += static_cast<sz>(result);
+        }
+#else
+        auto random_device = std::random_device();
+        for (auto &value : pool_)
+        {
+            value = random_device();
+        }
+#endif
+    }
+
+    std::array<result_type, POOL_SIZE> pool_;
+    sz pos_ = POOL_SIZE;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "nickname_key.h"
+#include "prefetch.h"
+#include "types.h"
+
+// NicknameKey만을 저장하는 open addressing(linear probing) 해시 셋
+// 슬롯 하나가 8바이트이며, 적재율이 MAX_LOAD_FACTOR를 넘으면 용량을 두 배로 늘린다.
+class FlatNicknameSet
+{
+  public:
+    constexpr static auto MAX_LOAD_FACTOR = 0.75;
+
+    FlatNicknameSet() = default;
+
+    explicit FlatNicknameSet(sz const expected_size)
+    {
+        reserve(expected_size);
+    }
+
+    void reserve(sz const expected_size)
+    {
+        auto const required = std::bit_ceil(static_cast<sz>(expected_size / MAX_LOAD_FACTOR) + 1);
+        if (slots_.size() < required)
+        {
+            rehash(required);
+        }
+    }
+
+    bool insert(NicknameKey const key)
+    {
+        if (static_cast<double>(size_ + 1) > static_cast<double>(slots_.size()) * MAX_LOAD_FACTOR)
+        {
+            rehash(slots_.empty() ? 16 : slots_.size() * 2);
+        }
+        for (auto idx = hash_nickname_key(key) & mask_;; idx = (idx + 1) & mask_)
+        {
+            if (slots_[idx] == key)
+            {
+                return false;
+            }
+            if (slots_[idx] == EMPTY_NICKNAME_KEY)
+            {
+                slots_[idx] = key;
+                ++size_;
+                return true;
+            }
+        }
+    }
+
+    bool contains(NicknameKey const key) const noexcept
+    {
+        return !slots_.empty() && contains_from(key, hash_nickname_key(key) & mask_);
+    }
+
+    // found[i]에 keys[i]가 있는지 기록한다. PREFETCH_BATCH_SIZE개씩 슬롯 위치를 먼저 계산해 프리페치한 뒤 찾으므로
+    // 키마다의 메모리 대기 시간이 서로 겹친다.
+    void contains_batch(std::span<NicknameKey const> const keys, bool *const found) const noexcept
+    {
+        if (slots_.empty())
+        {
+            std::fill_n(found, keys.size(), false);
+            return;
+        }
+        auto indices = std::array<sz, PREFETCH_BATCH_SIZE>();
+        for (auto begin = sz(); begin < keys.size(); begin += PREFETCH_BATCH_SIZE)
+        {
+            auto const count = std::min(PREFETCH_BATCH_SIZE, keys.size() - begin);
+            for (auto i = sz(); i < count; ++i)
+            {
+                indices[i] = hash_nickname_key(keys[begin + i]) & mask_;
+                prefetch_read(&slots_[indices[i]]);
+            }
+            for (auto i = sz(); i < count; ++i)
+            {
+                found[begin + i] = contains_from(keys[begin + i], indices[i]);
+            }
+        }
+    }
+
+    sz size() const noexcept
+    {
+        return size_;
+    }
+
+    sz capacity() const noexcept
+    {
+        return slots_.size();
+    }
+
+    double load_factor() const noexcept
+    {
+        return slots_.empty() ? 0.0 : static_cast<double>(size_) / static_cast<double>(slots_.size());
+    }
+
+    sz memory_usage() const noexcept
+    {
+        return slots_.size() * sizeof(NicknameKey);
+    }
+
+  private:
+    bool contains_from(NicknameKey const key, sz idx) const noexcept
+    {
+        for (;; idx = (idx + 1) & mask_)
+        {
+            if (slots_[idx] == key)
+            {
+                return true;
+            }
+            if (slots_[idx] == EMPTY_NICKNAME_KEY)
+            {
+                return false;
+            }
+        }
+    }
+
+    void rehash(sz const capacity)
+    {
+        auto old_slots = std::exchange(slots_, std::vector<NicknameKey>(capacity, EMPTY_NICKNAME_KEY));
+        mask_ = capacity - 1;
+        for (auto const key : old_slots)
+        {
+            if (key != EMPTY_NICKNAME_KEY)
+            {
+                auto idx = hash_nickname_key(key) & mask_;
+                while (slots_[idx] != EMPTY_NICKNAME_KEY)
+                {
+                    idx = (idx + 1) & mask_;
+                }
+                slots_[idx] = key;
+            }
+        }
+    }
+
+    std::vector<NicknameKey> slots_;
+    sz size_ = 0;
+    sz mask_ = 0;
+};
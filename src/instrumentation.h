@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "types.h"
+
+// 프로세스 전체에서 호출된 operator new의 횟수. main.cc에서 전역 operator new를 대체해 센다.
+// 여러 케이스가 동시에 실행되면 같은 구간의 할당이 함께 세어진다.
+inline std::atomic<u64> &allocation_counter() noexcept
+{
+    static auto counter = std::atomic<u64>(0);
+    return counter;
+}
+
+inline u64 num_allocations() noexcept
+{
+    return allocation_counter().load(std::memory_order_relaxed);
+}
+
+// 한 단계(fill, probe 등)에 걸린 시간, 처리한 항목 수, 그동안의 할당 횟수
+struct PhaseStats
+{
+    std::string_view name;
+    double seconds;
+    sz num_items;
+    u64 num_allocations;
+
+    double items_per_second() const noexcept
+    {
+        return 0 < seconds ? static_cast<double>(num_items) / seconds : 0.0;
+    }
+};
+
+// 생성 시점부터의 경과 시간과 할당 횟수를 잰다.
+class PhaseTimer
+{
+  public:
+    PhaseTimer() noexcept : start_(std::chrono::steady_clock::now()), start_allocations_(num_allocations())
+    {
+    }
+
+    PhaseStats finish(std::string_view const name, sz const num_items) const noexcept
+    {
+        auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_);
+        return PhaseStats{name, elapsed.count(), num_items, num_allocations() - start_allocations_};
+    }
+
+  private:
+    std::chrono::steady_clock::time_point start_;
+    u64 start_allocations_;
+};
+
+// JSON 문자열 리터럴로 기록한다.
+inline void write_json_string(std::ostream &out, std::string_view const value)
+{
+    out << '"';
+    for (auto const ch : value)
+    {
+        if (ch == '"' || ch == '\\')
+        {
+            out << '\\' << ch;
+        }
+        else if (static_cast<unsigned char>(ch) < 0x20)
+        {
+            constexpr auto HEX = std::string_view("0123456789abcdef");
+            out << "\\u00" << HEX[ch >> 4 & 0xf] << HEX[ch & 0xf];
+        }
+        else
+        {
+            out << ch;
+        }
+    }
+    out << '"';
+}
+
+inline void write_json_phases(std::ostream &out, std::vector<PhaseStats> const &phases)
+{
+    out << '[';
+    for (auto i = sz(); i < phases.size(); ++i)
+    {
+        auto const &phase = phases[i];
+        out << (0 < i ? ", " : "") << "{\"name\": ";
+        write_json_string(out, phase.name);
+        out << ", \"seconds\": " << phase.seconds << ", \"items\": " << phase.num_items
+            << ", \"items_per_second\": " << phase.items_per_second() << ", \"allocations\": " << phase.num_allocations
+            << '}';
+    }
+    out << ']';
+}
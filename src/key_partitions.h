@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "nickname_key.h"
+#include "types.h"
+
+// 키를 해시의 상위 비트로 나눈 파티션들. 같은 키는 항상 같은 파티션에 들어가므로 파티션마다 따로 정렬하고 셀 수 있다.
+// spill_dir이 비어 있지 않다면 파티션을 그 디렉터리의 파일에 기록해, 메모리에는 처리 중인 파티션만 올린다.
+// 같은 spill_dir을 쓰는 다른 프로세스와 파일이 겹치지 않도록 파일 이름에 임의의 값을 넣는다.
+// 여러 케이스가 동시에 파티션을 기록해도 열린 파일이 쌓이지 않도록, 파일은 기록하거나 읽는 동안에만 연다.
+// 파일을 쓰거나 읽지 못하면 std::runtime_error를 던진다.
+class KeyPartitions
+{
+  public:
+    constexpr static auto NUM_PARTITION_BITS = 8;
+    constexpr static auto NUM_PARTITIONS = static_cast<sz>(1) << NUM_PARTITION_BITS;
+
+    KeyPartitions(std::filesystem::path const &spill_dir, std::string_view const name)
+        : partitions_(std::make_unique<Partition[]>(NUM_PARTITIONS))
+    {
+        if (spill_dir.empty())
+        {
+            return;
+        }
+        auto const prefix = std::string(name) + "." + std::to_string(std::random_device()()) + ".";
+        for (auto i = sz(); i < NUM_PARTITIONS; ++i)
+        {
+            partitions_[i].path = spill_dir / (prefix + std::to_string(i) + ".keys");
+        }
+    }
+
+    KeyPartitions(KeyPartitions const &) = delete;
+    KeyPartitions &operator=(KeyPartitions const &) = delete;
+
+    ~KeyPartitions()
+    {
+        for (auto i = sz(); i < NUM_PARTITIONS; ++i)
+        {
+            remove(partitions_[i]);
+        }
+    }
+
+    static sz partition_of(NicknameKey const key) noexcept
+    {
+        return static_cast<sz>(hash_nickname_key(key) >> (64 - NUM_PARTITION_BITS));
+    }
+
+    // 여러 스레드에서 동시에 호출할 수 있다.
+    void append(sz const partition, std::span<NicknameKey const> const keys)
+    {
+        auto &target = partitions_[partition];
+        auto const lock = std::lock_guard(target.mutex);
+        if (target.path.empty())
+        {
+            target.keys.insert(target.keys.end(), keys.begin(), keys.end());
+            return;
+        }
+
+        auto *const file = std::fopen(target.path.string().c_str(), "ab");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("failed to create spill file: " + target.path.string());
+        }
+        target.spilled = true;
+        auto const written = std::fwrite(keys.data(), sizeof(NicknameKey), keys.size(), file) == keys.size();
+        if (std::fclose(file) != 0 || !written)
+        {
+            throw std::runtime_error("failed to write spill file: " + target.path.string());
+        }
+    }
+
+    // 파티션의 모든 키를 꺼내고 파티션을 비운다. 서로 다른 파티션은 동시에 꺼낼 수 있다.
+    std::vector<NicknameKey> take(sz const partition)
+    {
+        auto &source = partitions_[partition];
+        auto const lock = std::lock_guard(source.mutex);
+        if (source.path.empty())
+        {
+            return std::move(source.keys);
+        }
+        if (!source.spilled)
+        {
+            return std::vector<NicknameKey>();
+        }
+
+        auto ec = std::error_code();
+        auto const size = std::filesystem::file_size(source.path, ec);
+        auto keys = std::vector<NicknameKey>(ec ? 0 : static_cast<sz>(size) / sizeof(NicknameKey));
+        auto *const file = ec ? nullptr : std::fopen(source.path.string().c_str(), "rb");
+        auto const read =
+            file != nullptr && std::fread(keys.data(), sizeof(NicknameKey), keys.size(), file) == keys.size();
+        if (file != nullptr)
+        {
+            std::fclose(file);
+        }
+        if (!read)
+        {
+            throw std::runtime_error("failed to read spill file: " + source.path.string());
+        }
+        remove(source);
+        return keys;
+    }
+
+  private:
+    struct Partition
+    {
+        std::mutex mutex;
+        std::vector<NicknameKey> keys;
+        // path가 비어 있다면 keys에 모으고, 아니라면 path의 파일에 덧붙인다. spilled는 파일이 생성되었는지를 나타낸다.
+        std::filesystem::path path;
+        bool spilled = false;
+    };
+
+    static void remove(Partition &partition) noexcept
+    {
+        if (partition.spilled)
+        {
+            partition.spilled = false;
+            auto ec = std::error_code();
+            std::filesystem::remove(partition.path, ec);
+        }
+    }
+
+    std::unique_ptr<Partition[]> partitions_;
+};
+
+// 스레드마다 하나씩 두고 파티션별로 BUFFER_SIZE개씩 모아 KeyPartitions에 넘긴다.
+// KeyPartitions::append는 예외를 던질 수 있으므로 소멸자에서 넘기지 않는다. 남은 키는 flush를 호출해 넘겨야 한다.
+class PartitionedKeyWriter
+{
+  public:
+    constexpr static auto BUFFER_SIZE = static_cast<sz>(1024);
+
+    explicit PartitionedKeyWriter(KeyPartitions &partitions) : partitions_(partitions)
+    {
+        for (auto &buffer : buffers_)
+        {
+            buffer.reserve(BUFFER_SIZE);
+        }
+    }
+
+    PartitionedKeyWriter(PartitionedKeyWriter const &) = delete;
+    PartitionedKeyWriter &operator=(PartitionedKeyWriter const &) = delete;
+
+    void push(NicknameKey const key)
+    {
+        auto const partition = KeyPartitions::partition_of(key);
+        auto &buffer = buffers_[partition];
+        buffer.push_back(key);
+        if (buffer.size() == BUFFER_SIZE)
+        {
+            partitions_.append(partition, buffer);
+            buffer.clear();
+        }
+    }
+
+    void flush()
+    {
+        for (auto partition = sz(); partition < buffers_.size(); ++partition)
+        {
+            if (!buffers_[partition].empty())
+            {
+                partitions_.append(partition, buffers_[partition]);
+                buffers_[partition].clear();
+            }
+        }
+    }
+
+  private:
+    KeyPartitions &partitions_;
+    std::array<std::vector<NicknameKey>, KeyPartitions::NUM_PARTITIONS> buffers_;
+};
+
+// NicknameKey는 최대 60비트이므로 11비트씩 6번의 LSD radix sort로 정렬한다. scratch는 keys와 같은 크기로 맞춰진다.
+inline void radix_sort_keys(std::vector<NicknameKey> &keys, std::vector<NicknameKey> &scratch)
+{
+    constexpr static auto DIGIT_BITS = 11;
+    constexpr static auto NUM_BUCKETS = static_cast<sz>(1) << DIGIT_BITS;
+    constexpr static auto NUM_KEY_BITS = static_cast<int>(NICKNAME_SYMBOL_BITS * MAX_PACKED_NICKNAME_LEN);
+
+    scratch.resize(keys.size());
+    auto counts = std::array<sz, NUM_BUCKETS>();
+    for (auto shift = 0; shift < NUM_KEY_BITS; shift += DIGIT_BITS)
+    {
+        counts.fill(0);
+        for (auto const key : keys)
+        {
+            ++counts[key >> shift & (NUM_BUCKETS - 1)];
+        }
+        // 모든 키가 같은 자리 값을 가진다면 이 자리는 건너뛴다.
+        if (std::ranges::find(counts, keys.size()) != counts.end())
+        {
+            continue;
+        }
+        for (auto bucket = sz(), offset = sz(); bucket < NUM_BUCKETS; ++bucket)
+        {
+            offset += std::exchange(counts[bucket], offset);
+        }
+        for (auto const key : keys)
+        {
+            scratch[counts[key >> shift & (NUM_BUCKETS - 1)]++] = key;
+        }
+        keys.swap(scratch);
+    }
+}
+
+struct SortedKeyCounts
+{
+    sz num_unique;
+    sz num_duplicates;
+    sz num_collisions;
+};
+
+// population과 probes는 정렬되어 있어야 한다. population에서 앞의 키와 같은 키의 수를 num_duplicates로,
+// probes 중 population에 있는 키의 수를 num_collisions로 센다.
+inline SortedKeyCounts count_sorted_keys(std::span<NicknameKey const> const population,
+                                         std::span<NicknameKey const> const probes) noexcept
+{
+    auto counts = SortedKeyCounts{0, 0, 0};
+    for (auto i = sz(); i < population.size(); ++i)
+    {
+        if (0 < i && population[i] == population[i - 1])
+        {
+            ++counts.num_duplicates;
+        }
+        else
+        {
+            ++counts.num_unique;
+        }
+    }
+    auto it = population.begin();
+    for (auto const key : probes)
+    {
+        while (it != population.end() && *it < key)
+        {
+            ++it;
+        }
+        if (it != population.end() && *it == key)
+        {
+            ++counts.num_collisions;
+        }
+    }
+    return counts;
+}
@@ -1,338 +1,1488 @@
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <optional>
 #include <random>
 #include <ranges>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <thread>
-#include <tuple>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
-using sz = std::size_t;
-using u8 = std::uint8_t;
-using i32 = std::int32_t;
-using WordDB = std::vector<std::vector<std::string>>;
+#include "batch_nickname_sampler.h"
+#include "blocked_bloom_filter.h"
+#include "bounded_random.h"
+#include "cli.h"
+#include "collision_model.h"
+#include "composition_plan.h"
+#include "concurrent_nickname_set.h"
+#include "entropy_pool.h"
+#include "flat_nickname_set.h"
+#include "instrumentation.h"
+#include "key_partitions.h"
+#include "nickname_dump.h"
+#include "nickname_key.h"
+#include "nickname_output.h"
+#include "numa.h"
+#include "parallel.h"
+#include "prefetch.h"
+#include "progress.h"
+#include "random_engines.h"
+#include "reference_nickname_set.h"
+#include "sample_nickname.h"
+#include "sample_nickname_opt.h"
+#include "shard_runs.h"
+#include "types.h"
+#include "word_db.h"
 
-constexpr static auto MAX_NICKNAME_LEN = static_cast<sz>(12);
 constexpr static auto NUM_INITIAL_NICKNAMES = static_cast<sz>(10'000'000);
 constexpr static auto NUM_TRIES = static_cast<sz>(50'000'000);
 
-std::filesystem::path get_wordlist_txt_path() noexcept
+// --preset으로 고르는 작업량. 빠른 회귀 실행에서 같은 작업을 비교할 수 있도록, 시드가 지정되지 않았다면 PRESET_SEED를
+// 사용한다.
+struct WorkloadPreset
 {
-    auto const project_dir = std::filesystem::path(__FILE__).parent_path().parent_path();
-    return project_dir / "external" / "wordlist" / "wordlist-20210729.txt";
-}
+    std::string_view name;
+    sz num_initial_nicknames;
+    sz num_tries;
+};
+
+constexpr static auto WORKLOAD_PRESETS = std::array{
+    WorkloadPreset{"full", NUM_INITIAL_NICKNAMES, NUM_TRIES},
+    WorkloadPreset{"medium", 1'000'000, 5'000'000},
+    WorkloadPreset{"small", 100'000, 500'000},
+    WorkloadPreset{"smoke", 10'000, 50'000},
+};
+
+constexpr static auto PRESET_SEED = static_cast<u64>(20210729);
 
-WordDB load_word_db(std::string const &path)
+// 할당 횟수를 세기 위해 전역 operator new와 operator delete를 대체한다. nothrow 버전은 표준에 따라 이 함수들을 호출한다.
+// 모든 버전이 같은 두 함수로 할당하고 해제하므로, 어떤 new로 얻은 포인터든 어떤 delete로 해제해도 짝이 맞는다.
+// alignment가 0이라면 기본 정렬로 할당한다.
+void *allocate_counted(std::size_t const size, std::size_t const alignment)
 {
-    auto f = std::ifstream(path);
-    if (!f.is_open())
+    allocation_counter().fetch_add(1, std::memory_order_relaxed);
+    auto *ptr = static_cast<void *>(nullptr);
+    if (alignment == 0)
     {
-        spdlog::critical("failed to open word list file");
-        std::exit(-1);
+        ptr = std::malloc(size != 0 ? size : 1);
     }
-
-    auto db = WordDB(static_cast<sz>(MAX_NICKNAME_LEN + 1));
-    for (auto line = std::string(); !std::getline(f, line).eof();)
+    else
     {
-        if (line.length() - 2 < db.size())
-        {
-            db[line.length() - 2].emplace_back(std::string_view(line.c_str() + 1, line.length() - 2));
-        }
+#if defined(_WIN32)
+        ptr = _aligned_malloc(size != 0 ? size : 1, alignment);
+#else
+        ptr = std::aligned_alloc(alignment, (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment);
+#endif
     }
-    return db;
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
 }
 
-template <typename RandomEngine>
-char sample_ascii(RandomEngine &random_engine)
+void deallocate_counted(void *const ptr, std::size_t const alignment) noexcept
 {
-    constexpr auto NUM_DIGITS = '9' - '0' + 1;
-    constexpr auto NUM_ALPHAS = ('Z' - 'A' + 1) * 2;
-    auto ch = std::uniform_int_distribution<int>(0, NUM_ALPHAS + NUM_DIGITS - 1)(random_engine);
-    if (ch < NUM_DIGITS)
+#if defined(_WIN32)
+    if (alignment != 0)
     {
-        return static_cast<char>('0' + ch);
+        _aligned_free(ptr);
+        return;
     }
-    ch -= NUM_DIGITS;
-    return static_cast<char>(ch <= 'Z' - 'A' ? ('A' + ch) : ('a' + (ch - ('Z' - 'A' + 1))));
+#else
+    static_cast<void>(alignment);
+#endif
+    std::free(ptr);
 }
 
-template <typename RandomEngine>
-char sample_digit(RandomEngine &random_engine)
+void *operator new(std::size_t const size)
 {
-    auto const ch = std::uniform_int_distribution<int>('0', '9')(random_engine);
-    return static_cast<char>(ch);
+    return allocate_counted(size, 0);
 }
 
-template <typename RandomEngine>
-char sample_ascii_lower(RandomEngine &random_engine)
+void *operator new[](std::size_t const size)
 {
-    auto const ch = std::uniform_int_distribution<int>('a', 'z')(random_engine);
-    return static_cast<char>(ch);
+    return allocate_counted(size, 0);
 }
 
-template <typename RandomEngine>
-std::string sample_word(RandomEngine &random_engine, WordDB const &word_db, sz const min_len, sz const max_len)
+void *operator new(std::size_t const size, std::align_val_t const alignment)
 {
-    auto it = std::ranges::next(std::ranges::cbegin(word_db), min_len);
-    auto const num_candidates = std::reduce(it, std::ranges::next(it, max_len - min_len + 1), static_cast<sz>(0),
-                                            [](auto const total, auto const &it) { return total + it.size(); });
-    if (num_candidates == 0)
-    {
-        constexpr auto msg = "there are no words to sample";
-        spdlog::critical(msg);
-        throw std::runtime_error(msg);
-    }
+    return allocate_counted(size, static_cast<std::size_t>(alignment));
+}
 
-    auto idx = std::uniform_int_distribution<sz>(0, num_candidates - 1)(random_engine);
-    while (it->size() <= idx)
-    {
-        idx -= (it++)->size();
-    }
-    return it->at(idx);
+void *operator new[](std::size_t const size, std::align_val_t const alignment)
+{
+    return allocate_counted(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *const ptr) noexcept
+{
+    deallocate_counted(ptr, 0);
+}
+
+void operator delete[](void *const ptr) noexcept
+{
+    deallocate_counted(ptr, 0);
 }
 
-template <typename RandomEngine>
-std::string sample_and_mangle_word(RandomEngine &random_engine, WordDB const &word_db, sz const min_len,
-                                   sz const max_len, double const mangling_factor)
+void operator delete(void *const ptr, std::size_t) noexcept
+{
+    deallocate_counted(ptr, 0);
+}
+
+void operator delete[](void *const ptr, std::size_t) noexcept
+{
+    deallocate_counted(ptr, 0);
+}
+
+void operator delete(void *const ptr, std::align_val_t const alignment) noexcept
+{
+    deallocate_counted(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void *const ptr, std::align_val_t const alignment) noexcept
+{
+    deallocate_counted(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *const ptr, std::size_t, std::align_val_t const alignment) noexcept
+{
+    deallocate_counted(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void *const ptr, std::size_t, std::align_val_t const alignment) noexcept
+{
+    deallocate_counted(ptr, static_cast<std::size_t>(alignment));
+}
+
+// BATCH는 REUSE처럼 엔진 하나를 계속 사용하되, BatchNicknameSampler로 닉네임을 묶음 단위로 생성한다.
+enum class EngineUsage
+{
+    REUSE,
+    RECREATE,
+    BATCH,
+};
+
+struct ExperimentOpt
+{
+    SampleNicknameOpt nickname_opt;
+    std::vector<sz> population_checkpoints;
+    sz num_tries;
+    sz num_threads;
+    std::optional<u64> seed;
+    double bloom_bits_per_key;
+    std::filesystem::path spill_dir;
+    bool reference_set;
+    bool numa_replicate;
+    double target_precision;
+    sz shard_index;
+    sz num_shards;
+    std::filesystem::path shard_dir;
+};
+
+// 각 단계의 작업은 CHUNK_SIZE개의 닉네임 단위로 나뉘며, 청크마다 (시드, 청크 번호)로부터 독립된 난수 스트림을 사용한다.
+// 따라서 시드가 같다면 스레드 수와 관계없이 같은 결과를 얻는다.
+constexpr static auto CHUNK_SIZE = static_cast<sz>(1 << 16);
+
+// REUSE와 RECREATE 모드는 청크마다 구성 계획을 한 번 만들고, 닉네임마다 계획 하나를 뽑아 조각을 채운다.
+// RECREATE 모드에서는 닉네임마다 32비트 시드로 엔진을 새로 생성한다.
+// 시드가 지정되지 않은 실험에서는 그 시드를 운영체제 난수 소스에서 한꺼번에 읽어 둔 EntropyPool에서 얻는다.
+template <typename RandomEngine, EngineUsage USAGE, typename Consumer>
+void generate_nickname_keys(WordDB const &word_db, ExperimentOpt const &opt, u64 const chunk_seed, sz const count,
+                            Consumer &&consume)
 {
-    auto piece = sample_word(random_engine, word_db, min_len, max_len);
-    auto indices = std::vector<sz>(piece.length());
-    std::iota(std::ranges::begin(indices), std::ranges::end(indices), 0);
-    auto magling_magnitude = static_cast<i32>(std::round(piece.length() / mangling_factor));
-    while (0 < magling_magnitude--)
+    if constexpr (USAGE == EngineUsage::REUSE)
     {
-        auto idx = std::uniform_int_distribution<sz>(0, indices.size() - 1)(random_engine);
-        std::swap(indices[idx], indices.back());
-        idx = indices.back();
-        indices.pop_back();
-        if (idx == 0)
+        auto const plans = CompositionPlans(word_db, opt.nickname_opt);
+        auto pesudo_random_engine = make_random_engine<RandomEngine>(chunk_seed);
+        for (auto i = sz(); i < count; ++i)
         {
-            piece[idx] = sample_ascii_lower(random_engine);
+            consume(sample_nickname_key(pesudo_random_engine, plans));
         }
-        else
+    }
+    else if constexpr (USAGE == EngineUsage::BATCH)
+    {
+        auto pesudo_random_engine = make_random_engine<RandomEngine>(chunk_seed);
+        auto const sampler = BatchNicknameSampler(word_db, opt.nickname_opt);
+        auto keys = std::array<NicknameKey, BatchNicknameSampler::BATCH_SIZE>();
+        for (auto begin = sz(); begin < count; begin += keys.size())
         {
-            piece[idx] = static_cast<char>(std::tolower(sample_ascii(random_engine)));
+            auto const batch = std::span(keys.data(), std::min(keys.size(), count - begin));
+            sampler.sample(pesudo_random_engine, batch);
+            std::ranges::for_each(batch, consume);
+        }
+    }
+    else
+    {
+        auto const plans = CompositionPlans(word_db, opt.nickname_opt);
+        auto entropy_pool = EntropyPool();
+        auto seeder = SplitMix64(chunk_seed);
+        for (auto i = sz(); i < count; ++i)
+        {
+            auto pesudo_random_engine = RandomEngine(opt.seed ? static_cast<u32>(seeder()) : entropy_pool());
+            consume(sample_nickname_key(pesudo_random_engine, plans));
         }
     }
-    return piece;
 }
 
-struct SampleNicknameOpt
+// 한 라운드에서 부족한 개수만큼만 생성하므로 집합의 크기는 목표를 넘지 않으며, 합집합은 삽입 순서와 무관하다.
+// filter가 있다면 집합에 새로 들어간 닉네임을 filter에도 넣는다. 생성한 닉네임의 수를 돌려준다.
+template <typename RandomEngine, EngineUsage USAGE, typename NicknameSet>
+sz fill_nickname_db(NicknameSet &nickname_db, BlockedBloomFilter *const filter, WordDB const &word_db,
+                      ExperimentOpt const &opt, CaseProgress &progress, u64 const seed, sz const num_nicknames)
 {
-    sz min_len;
-    sz max_len;
-    sz min_word_len;
-    sz max_word_len;
-};
+    progress.begin_fill(num_nicknames);
+    auto next_chunk = sz();
+    auto num_generated = sz();
+    while (nickname_db.size() < num_nicknames)
+    {
+        auto const num_required = num_nicknames - nickname_db.size();
+        auto const num_chunks = (num_required + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        parallel_for(opt.num_threads, num_chunks, [&](sz const chunk, sz) {
+            auto const count = std::min(CHUNK_SIZE, num_required - chunk * CHUNK_SIZE);
+            generate_nickname_keys<RandomEngine, USAGE>(word_db, opt, derive_seed(seed, next_chunk + chunk), count,
+                                                        [&](NicknameKey const nickname) {
+                                                            if (nickname_db.insert(nickname) && filter != nullptr)
+                                                            {
+                                                                filter->insert(nickname);
+                                                            }
+                                                        });
+            progress.add_generated(count);
+        });
+        next_chunk += num_chunks;
+        num_generated += num_required;
+    }
+    return num_generated;
+}
 
-static auto const SAMPLE_NICKNAME_OPT = SampleNicknameOpt{8, 8, 3, 8};
+struct ProbeResult
+{
+    sz num_tries;
+    sz num_collisions;
+    sz num_filter_passes;
+};
 
-template <typename RandomEngine>
-std::string sample_nickname(RandomEngine &random_engine, WordDB const &word_db, SampleNicknameOpt const &opt)
+// filter가 있다면 filter를 통과한 닉네임만 집합에서 찾는다. filter가 없다면 모든 시도가 통과한 것으로 센다.
+// 닉네임을 PREFETCH_BATCH_SIZE개씩 모아 일괄 조회하므로 조회마다의 캐시 미스가 서로 겹친다.
+// numa_replicate라면 청크마다 그 청크를 실행하는 노드의 집합과 filter 복제본을 조회한다.
+// target_precision이 0보다 크다면, 앞에서부터 연속해 끝난 청크들로 구한 충돌 확률의 95% 신뢰 구간 반폭이 추정치의
+// target_precision배 이하가 되는 즉시 나머지 청크를 건너뛰고 그때까지의 청크만 센다. 멈추는 지점은 청크의 순서로만
+// 정해지므로, 시드가 같다면 스레드 수와 관계없이 같은 결과를 얻는다.
+template <typename RandomEngine, EngineUsage USAGE, typename NicknameSet>
+ProbeResult probe_nickname_db(NicknameSet const &nickname_db, BlockedBloomFilter const *const filter,
+                              WordDB const &word_db, ExperimentOpt const &opt, CaseProgress &progress, u64 const seed,
+                              sz const num_tries)
 {
-    auto pieces = std::vector<std::string>();
-    auto chance = std::uniform_int_distribution<sz>(opt.min_len, opt.max_len)(random_engine);
-    while (0 < chance)
+    struct ChunkCounts
+    {
+        sz num_collisions;
+        sz num_filter_passes;
+        bool done;
+    };
+    auto const num_chunks = (num_tries + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    auto chunk_counts = std::vector<ChunkCounts>(num_chunks);
+    auto counted = ProbeResult{0, 0, 0};
+    auto num_counted_chunks = sz();
+    auto end_chunk = std::atomic<sz>(num_chunks);
+    auto counted_mutex = std::mutex();
+    auto const chunk_size = [num_tries](sz const chunk) { return std::min(CHUNK_SIZE, num_tries - chunk * CHUNK_SIZE); };
+    progress.begin_probe(num_tries);
+
+    auto nickname_db_replicas = NumaReplicas(nickname_db, opt.numa_replicate);
+    auto filter_replicas = std::optional<NumaReplicas<BlockedBloomFilter>>();
+    if (filter != nullptr)
     {
-        if (chance < opt.min_word_len)
+        filter_replicas.emplace(*filter, opt.numa_replicate);
+    }
+    parallel_for(opt.num_threads, num_chunks, [&](sz const chunk, sz) {
+        if (end_chunk.load(std::memory_order_relaxed) <= chunk)
         {
-            auto piece = std::string();
-            piece.push_back(sample_ascii_lower(random_engine));
-            for (--chance; 0 < chance; --chance)
+            return;
+        }
+        auto const &local_db = nickname_db_replicas.local();
+        auto const *const local_filter = filter_replicas ? &filter_replicas->local() : nullptr;
+        auto batch = std::array<NicknameKey, PREFETCH_BATCH_SIZE>();
+        auto found = std::array<bool, PREFETCH_BATCH_SIZE>();
+        auto batch_size = sz();
+        auto num_collisions = sz();
+        auto num_filter_passes = sz();
+        auto const resolve = [&]() {
+            if (local_filter != nullptr)
             {
-                piece.push_back(sample_ascii(random_engine));
+                local_filter->might_contain_batch(std::span(batch.data(), batch_size), found.data());
+                auto num_passes = sz();
+                for (auto i = sz(); i < batch_size; ++i)
+                {
+                    batch[num_passes] = batch[i];
+                    num_passes += found[i] ? 1 : 0;
+                }
+                batch_size = num_passes;
             }
-            pieces.emplace_back(std::move(piece));
-        }
-        else
+            num_filter_passes += batch_size;
+            local_db.contains_batch(std::span(batch.data(), batch_size), found.data());
+            num_collisions += static_cast<sz>(std::count(found.data(), found.data() + batch_size, true));
+            batch_size = 0;
+        };
+
+        generate_nickname_keys<RandomEngine, USAGE>(word_db, opt, derive_seed(seed, chunk), chunk_size(chunk),
+                                                    [&](NicknameKey const nickname) {
+                                                        batch[batch_size++] = nickname;
+                                                        if (batch_size == batch.size())
+                                                        {
+                                                            resolve();
+                                                        }
+                                                    });
+        resolve();
+        progress.add_tries(chunk_size(chunk), num_collisions);
+
+        auto const lock = std::lock_guard(counted_mutex);
+        chunk_counts[chunk] = ChunkCounts{num_collisions, num_filter_passes, true};
+        while (num_counted_chunks < end_chunk.load(std::memory_order_relaxed) && chunk_counts[num_counted_chunks].done)
         {
-            auto piece = sample_and_mangle_word(random_engine, word_db, opt.min_word_len,
-                                                std::min(opt.max_word_len, chance), 2.7);
-            chance -= piece.length();
-            piece[0] = static_cast<char>(std::toupper(piece[0]));
-            pieces.emplace_back(std::move(piece));
+            counted.num_tries += chunk_size(num_counted_chunks);
+            counted.num_collisions += chunk_counts[num_counted_chunks].num_collisions;
+            counted.num_filter_passes += chunk_counts[num_counted_chunks].num_filter_passes;
+            ++num_counted_chunks;
+            if (0 < opt.target_precision &&
+                has_converged(counted.num_collisions, counted.num_tries, opt.target_precision))
+            {
+                end_chunk.store(num_counted_chunks, std::memory_order_relaxed);
+            }
         }
-    }
-
-    std::shuffle(std::ranges::begin(pieces), std::ranges::end(pieces), random_engine);
-    return std::accumulate(std::ranges::cbegin(pieces), std::ranges::cend(pieces), std::string(),
-                           [](auto const &nickname, auto const &piece) { return nickname + piece; });
+    });
+    return counted;
 }
 
-// --------------------------------------------------------------------------------------------------
-// 32bit random engine 재사용
-// --------------------------------------------------------------------------------------------------
-void case01(WordDB const &word_db, std::tuple<sz, sz, double> &out)
+// filter_false_positive_rate는 충돌하지 않은 시도 중 filter를 통과한 비율이며, filter가 없다면 0이다.
+// num_duplicates는 정렬 모드에서 사전 생성한 닉네임 중 앞서 생성된 것과 같은 닉네임의 수이며, 그 외에는 0이다.
+// load_factor와 memory_usage는 닉네임 집합(과 filter)의 값이며, 정렬 모드에서는 0이다.
+struct CaseResult
 {
-    auto random_device = std::random_device();
-    auto pesudo_random_engine = std::mt19937(random_device());
+    sz num_initial_nicknames;
+    sz num_tries;
+    sz num_collisions;
+    double collision_rate;
+    double filter_false_positive_rate;
+    sz num_duplicates;
+    std::vector<PhaseStats> phases = {};
+    double load_factor = 0;
+    sz memory_usage = 0;
+};
 
-    auto nickname_db = std::unordered_set<std::string>();
-    while (nickname_db.size() < NUM_INITIAL_NICKNAMES)
+inline CaseResult make_case_result(sz const num_initial_nicknames, ProbeResult const &probe, bool const filtered)
+{
+    auto const num_misses = probe.num_tries - probe.num_collisions;
+    return CaseResult{num_initial_nicknames, probe.num_tries, probe.num_collisions,
+                      static_cast<double>(probe.num_collisions) / static_cast<double>(probe.num_tries) * 100,
+                      filtered && 0 < num_misses ? static_cast<double>(probe.num_filter_passes - probe.num_collisions) /
+                                                       static_cast<double>(num_misses) * 100
+                                                 : 0.0,
+                      0};
+}
+
+// bloom_bits_per_key가 0이 아니라면 가장 큰 집합 크기에 맞춘 BlockedBloomFilter를 만든다.
+inline std::optional<BlockedBloomFilter> make_prefilter(ExperimentOpt const &opt, sz const expected_size)
+{
+    if (opt.bloom_bits_per_key <= 0)
     {
-        nickname_db.emplace(sample_nickname(pesudo_random_engine, word_db, SAMPLE_NICKNAME_OPT));
+        return std::nullopt;
     }
+    return std::optional<BlockedBloomFilter>(std::in_place, expected_size, opt.bloom_bits_per_key);
+}
 
-    auto num_collisions = sz();
-    for (auto i = sz(); i < NUM_TRIES; ++i)
-    {
-        auto const nickname = sample_nickname(pesudo_random_engine, word_db, SAMPLE_NICKNAME_OPT);
-        if (nickname_db.contains(nickname))
+// 닉네임 집합을 population_checkpoints의 각 크기까지 차례로 키우며, 매 지점마다 num_tries번 충돌을 검사한다.
+// 검사에는 모든 지점에서 같은 난수 스트림을 사용하므로 지점 사이의 차이는 집합의 크기에서만 비롯된다.
+// 스레드가 하나라면 CAS 비용이 없는 FlatNicknameSet을, 그렇지 않다면 ConcurrentNicknameSet을 사용한다.
+// reference_set이라면 문자열을 저장하는 ReferenceNicknameSet을 사용한다.
+// 세 집합은 같은 원소를 가지므로 결과는 스레드 수나 집합의 종류와 관계없이 같다.
+template <typename RandomEngine, EngineUsage USAGE>
+void run_case(WordDB const &word_db, ExperimentOpt const &opt, u64 const stream, CaseProgress &progress,
+              std::vector<CaseResult> &out)
+{
+    auto const case_seed = derive_seed(opt.seed ? *opt.seed : random_device_seed(), stream);
+    auto const fill_seed = derive_seed(case_seed, 0);
+    auto const probe_seed = derive_seed(case_seed, 1);
+    auto const max_nicknames = std::ranges::max(opt.population_checkpoints);
+    auto filter = make_prefilter(opt, max_nicknames);
+    auto *const filter_ptr = filter ? &*filter : nullptr;
+    auto const run = [&](auto &&nickname_db) {
+        for (auto i = sz(); i < opt.population_checkpoints.size(); ++i)
         {
-            ++num_collisions;
+            auto const num_initial_nicknames = opt.population_checkpoints[i];
+            auto const fill_timer = PhaseTimer();
+            auto const num_generated = fill_nickname_db<RandomEngine, USAGE>(
+                nickname_db, filter_ptr, word_db, opt, progress, derive_seed(fill_seed, i), num_initial_nicknames);
+            auto const fill_stats = fill_timer.finish("fill", num_generated);
+
+            auto const probe_timer = PhaseTimer();
+            auto const probe = probe_nickname_db<RandomEngine, USAGE>(nickname_db, filter_ptr, word_db, opt, progress,
+                                                                      probe_seed, opt.num_tries);
+            auto result = make_case_result(num_initial_nicknames, probe, filter.has_value());
+            result.phases = {fill_stats, probe_timer.finish("probe", probe.num_tries)};
+            result.load_factor = nickname_db.load_factor();
+            result.memory_usage = nickname_db.memory_usage() + (filter ? filter->memory_usage() : 0);
+            out.push_back(std::move(result));
         }
-    }
+    };
 
-    std::get<0>(out) = NUM_TRIES;
-    std::get<1>(out) = num_collisions;
-    std::get<2>(out) = static_cast<double>(num_collisions) / NUM_TRIES * 100;
+    if (opt.reference_set)
+    {
+        run(ReferenceNicknameSet(max_nicknames));
+    }
+    else if (opt.num_threads == 1)
+    {
+        run(FlatNicknameSet(max_nicknames));
+    }
+    else
+    {
+        run(ConcurrentNicknameSet(max_nicknames));
+    }
 }
 
-// --------------------------------------------------------------------------------------------------
-// 32bit random engine 재생성
-// --------------------------------------------------------------------------------------------------
-void case02(WordDB const &word_db, std::tuple<sz, sz, double> &out)
+struct OutputOpt
+{
+    std::string path;
+    NicknameFormat format;
+    sz num_nicknames;
+};
+
+// 생성한 닉네임을 집합에 담지 않고 청크 순서대로 기록한다. 한 묶음의 청크 버퍼를 병렬로 채우는 동안
+// 다른 스레드가 이전 묶음을 기록하므로, 메모리는 버퍼 두 묶음만 사용한다.
+// 스트림은 run_case의 첫 번째 채우기 단계와 같으므로, 같은 시드라면 그 단계에서 집합에 넣는 닉네임들이 기록된다.
+template <typename RandomEngine, EngineUsage USAGE>
+void export_case(WordDB const &word_db, ExperimentOpt const &opt, u64 const stream, OutputOpt const &output)
 {
-    auto nickname_db = std::unordered_set<std::string>();
-    while (nickname_db.size() < NUM_INITIAL_NICKNAMES)
+    auto const case_seed = derive_seed(opt.seed ? *opt.seed : random_device_seed(), stream);
+    auto const seed = derive_seed(derive_seed(case_seed, 0), 0);
+    auto const max_len = opt.nickname_opt.max_len;
+    auto const num_chunks = (output.num_nicknames + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    auto const chunks_per_batch = opt.num_threads * 4;
+
+    auto writer = NicknameWriter(output.path);
+    if (output.format == NicknameFormat::KEY)
     {
-        auto random_device = std::random_device();
-        auto pesudo_random_engine = std::mt19937(random_device());
-        nickname_db.emplace(sample_nickname(pesudo_random_engine, word_db, SAMPLE_NICKNAME_OPT));
+        writer.write_key_file_header(output.num_nicknames);
     }
 
-    auto num_collisions = sz();
-    for (auto i = sz(); i < NUM_TRIES; ++i)
+    auto buffers = std::array<std::vector<std::vector<char>>, 2>();
+    for (auto &batch : buffers)
     {
-        auto random_device = std::random_device();
-        auto pesudo_random_engine = std::mt19937(random_device());
-        auto const nickname = sample_nickname(pesudo_random_engine, word_db, SAMPLE_NICKNAME_OPT);
-        if (nickname_db.contains(nickname))
+        batch.resize(chunks_per_batch);
+        for (auto &buffer : batch)
         {
-            ++num_collisions;
+            buffer.reserve(CHUNK_SIZE * nickname_record_size(output.format, max_len));
         }
     }
 
-    std::get<0>(out) = NUM_TRIES;
-    std::get<1>(out) = num_collisions;
-    std::get<2>(out) = static_cast<double>(num_collisions) / NUM_TRIES * 100;
+    auto writing = std::thread();
+    for (auto first_chunk = sz(), batch = sz(); first_chunk < num_chunks; first_chunk += chunks_per_batch, ++batch)
+    {
+        auto &chunk_buffers = buffers[batch % 2];
+        auto const num_batch_chunks = std::min(chunks_per_batch, num_chunks - first_chunk);
+        parallel_for(opt.num_threads, num_batch_chunks, [&](sz const i, sz) {
+            auto const chunk = first_chunk + i;
+            auto &buffer = chunk_buffers[i];
+            buffer.clear();
+            generate_nickname_keys<RandomEngine, USAGE>(
+                word_db, opt, derive_seed(seed, chunk), std::min(CHUNK_SIZE, output.num_nicknames - chunk * CHUNK_SIZE),
+                [&](NicknameKey const nickname) { append_nickname_record(output.format, max_len, nickname, buffer); });
+        });
+
+        if (writing.joinable())
+        {
+            writing.join();
+        }
+        writing = std::thread([&writer, &chunk_buffers, num_batch_chunks]() {
+            for (auto i = sz(); i < num_batch_chunks; ++i)
+            {
+                writer.write(chunk_buffers[i].data(), chunk_buffers[i].size());
+            }
+        });
+    }
+    if (writing.joinable())
+    {
+        writing.join();
+    }
+    writer.flush();
 }
 
-// --------------------------------------------------------------------------------------------------
-// 64bit random engine 재사용
-// --------------------------------------------------------------------------------------------------
-void case03(WordDB const &word_db, std::tuple<sz, sz, double> &out)
+// 기존 닉네임 덤프를 불러온 집합에 대해 충돌 검사만 수행한다. 검사 스트림은 run_case와 같다.
+template <typename RandomEngine, EngineUsage USAGE>
+CaseResult probe_baseline_case(ConcurrentNicknameSet const &nickname_db, BlockedBloomFilter const *const filter,
+                               WordDB const &word_db, ExperimentOpt const &opt, u64 const stream,
+                               CaseProgress &progress)
 {
-    auto random_device = std::random_device();
-    auto pesudo_random_engine = std::mt19937_64(random_device());
+    auto const case_seed = derive_seed(opt.seed ? *opt.seed : random_device_seed(), stream);
+    auto const probe_timer = PhaseTimer();
+    auto const probe = probe_nickname_db<RandomEngine, USAGE>(nickname_db, filter, word_db, opt, progress,
+                                                              derive_seed(case_seed, 1), opt.num_tries);
+    auto result = make_case_result(nickname_db.size(), probe, filter != nullptr);
+    result.phases = {probe_timer.finish("probe", probe.num_tries)};
+    result.load_factor = nickname_db.load_factor();
+    result.memory_usage = nickname_db.memory_usage() + (filter != nullptr ? filter->memory_usage() : 0);
+    return result;
+}
+
+// 정렬 모드에서 생성할 count개의 닉네임 중 청크 번호를 num_shards로 나눈 나머지가 shard_index인 청크들을 생성해
+// partitions에 모은다. 샤드로 나누지 않았다면 모든 청크를 생성한다. 생성한 닉네임의 수를 돌려준다.
+template <typename RandomEngine, EngineUsage USAGE>
+sz generate_key_partitions(WordDB const &word_db, ExperimentOpt const &opt, CaseProgress &progress,
+                           KeyPartitions &partitions, u64 const seed, sz const count)
+{
+    auto const num_chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    auto const num_shard_chunks =
+        opt.shard_index < num_chunks ? (num_chunks - opt.shard_index + opt.num_shards - 1) / opt.num_shards : 0;
+    auto const chunk_size = [&](sz const chunk) { return std::min(CHUNK_SIZE, count - chunk * CHUNK_SIZE); };
 
-    auto nickname_db = std::unordered_set<std::string>();
-    while (nickname_db.size() < NUM_INITIAL_NICKNAMES)
+    auto writers = std::vector<std::unique_ptr<PartitionedKeyWriter>>();
+    for (auto i = sz(); i < opt.num_threads; ++i)
     {
-        nickname_db.emplace(sample_nickname(pesudo_random_engine, word_db, SAMPLE_NICKNAME_OPT));
+        writers.push_back(std::make_unique<PartitionedKeyWriter>(partitions));
+    }
+    parallel_for(opt.num_threads, num_shard_chunks, [&](sz const i, sz const thread_idx) {
+        auto const chunk = opt.shard_index + i * opt.num_shards;
+        generate_nickname_keys<RandomEngine, USAGE>(
+            word_db, opt, derive_seed(seed, chunk), chunk_size(chunk),
+            [&writer = *writers[thread_idx]](NicknameKey const nickname) { writer.push(nickname); });
+        progress.add_generated(chunk_size(chunk));
+    });
+    for (auto const &writer : writers)
+    {
+        writer->flush();
     }
 
-    auto num_collisions = sz();
-    for (auto i = sz(); i < NUM_TRIES; ++i)
+    auto num_generated = sz();
+    for (auto i = sz(); i < num_shard_chunks; ++i)
     {
-        auto const nickname = sample_nickname(pesudo_random_engine, word_db, SAMPLE_NICKNAME_OPT);
-        if (nickname_db.contains(nickname))
+        num_generated += chunk_size(opt.shard_index + i * opt.num_shards);
+    }
+    return num_generated;
+}
+
+// 해시 셋 없이 정확히 센다. 사전 생성 닉네임 N개와 검사 닉네임을 해시의 상위 비트로 나눈 파티션에 모은 뒤,
+// 파티션마다 radix sort해 사전 생성 닉네임 중 중복된 수와 사전 생성 닉네임과 같은 검사 닉네임의 수를 센다.
+// 사전 생성 닉네임은 중복을 제거하지 않고 정확히 N번 생성한다. 스트림은 run_case와 같다.
+template <typename RandomEngine, EngineUsage USAGE>
+void run_sorted_case(WordDB const &word_db, ExperimentOpt const &opt, u64 const stream, CaseProgress &progress,
+                     std::vector<CaseResult> &out)
+{
+    auto const case_seed = derive_seed(opt.seed ? *opt.seed : random_device_seed(), stream);
+    auto const fill_seed = derive_seed(case_seed, 0);
+    auto const probe_seed = derive_seed(case_seed, 1);
+    for (auto i = sz(); i < opt.population_checkpoints.size(); ++i)
+    {
+        auto const num_initial_nicknames = opt.population_checkpoints[i];
+        auto population = KeyPartitions(opt.spill_dir, std::to_string(stream) + ".population");
+        auto probes = KeyPartitions(opt.spill_dir, std::to_string(stream) + ".probe");
+        auto const generate_timer = PhaseTimer();
+        progress.begin_fill(num_initial_nicknames + opt.num_tries);
+        generate_key_partitions<RandomEngine, USAGE>(word_db, opt, progress, population, derive_seed(fill_seed, i),
+                                                     num_initial_nicknames);
+        generate_key_partitions<RandomEngine, USAGE>(word_db, opt, progress, probes, probe_seed, opt.num_tries);
+        auto const generate_stats = generate_timer.finish("generate", num_initial_nicknames + opt.num_tries);
+        auto const sort_timer = PhaseTimer();
+        auto counts = std::vector<SortedKeyCounts>(KeyPartitions::NUM_PARTITIONS);
+        auto scratches = std::vector<std::vector<NicknameKey>>(opt.num_threads);
+        parallel_for(opt.num_threads, KeyPartitions::NUM_PARTITIONS, [&](sz const partition, sz const thread_idx) {
+            auto population_keys = population.take(partition);
+            auto probe_keys = probes.take(partition);
+            radix_sort_keys(population_keys, scratches[thread_idx]);
+            radix_sort_keys(probe_keys, scratches[thread_idx]);
+            counts[partition] = count_sorted_keys(population_keys, probe_keys);
+        });
+
+        auto result = CaseResult{num_initial_nicknames, opt.num_tries, 0, 0.0, 0.0, 0};
+        result.phases = {generate_stats, sort_timer.finish("sort", num_initial_nicknames + opt.num_tries)};
+        for (auto const &count : counts)
         {
-            ++num_collisions;
+            result.num_collisions += count.num_collisions;
+            result.num_duplicates += count.num_duplicates;
         }
+        result.collision_rate =
+            static_cast<double>(result.num_collisions) / static_cast<double>(opt.num_tries) * 100;
+        out.push_back(std::move(result));
     }
-
-    std::get<0>(out) = NUM_TRIES;
-    std::get<1>(out) = num_collisions;
-    std::get<2>(out) = static_cast<double>(num_collisions) / NUM_TRIES * 100;
 }
 
-// --------------------------------------------------------------------------------------------------
-// 64bit random engine 재생성
-// --------------------------------------------------------------------------------------------------
-void case04(WordDB const &word_db, std::tuple<sz, sz, double> &out)
+// run_sorted_case의 생성과 정렬 중 opt.shard_index번째 샤드의 몫만 수행하고, 세는 대신 파티션별로 정렬한 키를
+// opt.shard_dir의 샤드 파일에 기록한다. merge_shard_runs가 모든 샤드의 파일을 합쳐 run_sorted_case와 같은 결과를
+// 계산한다. 사전 생성 키는 샤드 안에서 중복을 제거해 기록하고, 결과는 out에 남기지 않는다.
+template <typename RandomEngine, EngineUsage USAGE>
+void run_shard_case(WordDB const &word_db, ExperimentOpt const &opt, u64 const stream, CaseProgress &progress,
+                    std::vector<CaseResult> &)
 {
-    auto nickname_db = std::unordered_set<std::string>();
-    while (nickname_db.size() < NUM_INITIAL_NICKNAMES)
+    auto const case_seed = derive_seed(*opt.seed, stream);
+    auto const fill_seed = derive_seed(case_seed, 0);
+    auto const probe_seed = derive_seed(case_seed, 1);
+    for (auto i = sz(); i < opt.population_checkpoints.size(); ++i)
     {
-        auto random_device = std::random_device();
-        auto pesudo_random_engine = std::mt19937_64(random_device());
-        nickname_db.emplace(sample_nickname(pesudo_random_engine, word_db, SAMPLE_NICKNAME_OPT));
+        auto const num_initial_nicknames = opt.population_checkpoints[i];
+        auto population = KeyPartitions(opt.spill_dir, std::to_string(stream) + ".population");
+        auto probes = KeyPartitions(opt.spill_dir, std::to_string(stream) + ".probe");
+        auto const generate_timer = PhaseTimer();
+        progress.begin_fill((num_initial_nicknames + opt.num_tries) / opt.num_shards);
+        auto const num_population_keys = generate_key_partitions<RandomEngine, USAGE>(
+            word_db, opt, progress, population, derive_seed(fill_seed, i), num_initial_nicknames);
+        auto const num_probe_keys =
+            generate_key_partitions<RandomEngine, USAGE>(word_db, opt, progress, probes, probe_seed, opt.num_tries);
+        auto const generate_stats = generate_timer.finish("generate", num_population_keys + num_probe_keys);
+
+        auto const write_timer = PhaseTimer();
+        auto const header =
+            ShardRunsHeader{SHARD_RUNS_MAGIC, SHARD_RUNS_VERSION, static_cast<u32>(KeyPartitions::NUM_PARTITIONS),
+                            opt.shard_index, opt.num_shards, *opt.seed, stream, opt.nickname_opt,
+                            num_initial_nicknames, opt.num_tries, word_db.first_index.back(),
+                            word_db_fingerprint(word_db), num_population_keys, num_probe_keys};
+        auto const path = shard_runs_path(opt.shard_dir, header);
+        auto writer = ShardRunsWriter(path, header);
+        auto scratches = std::vector<std::vector<NicknameKey>>(opt.num_threads);
+        parallel_for(opt.num_threads, KeyPartitions::NUM_PARTITIONS, [&](sz const partition, sz const thread_idx) {
+            auto population_keys = population.take(partition);
+            auto probe_keys = probes.take(partition);
+            radix_sort_keys(population_keys, scratches[thread_idx]);
+            radix_sort_keys(probe_keys, scratches[thread_idx]);
+            population_keys.erase(std::ranges::unique(population_keys).begin(), population_keys.end());
+            writer.write_partition(partition, population_keys, probe_keys);
+        });
+        auto const num_bytes = writer.finish();
+        auto const write_stats = write_timer.finish("write", num_population_keys + num_probe_keys);
+        spdlog::info("샤드 {}/{} 기록: {} ({} 바이트, 키 {}개), generate {}s, sort/write {}s", opt.shard_index,
+                     opt.num_shards, path.string(), num_bytes, num_population_keys + num_probe_keys,
+                     generate_stats.seconds, write_stats.seconds);
     }
+}
+
+using CaseFn = void (*)(WordDB const &, ExperimentOpt const &, u64, CaseProgress &, std::vector<CaseResult> &);
+using ExportFn = void (*)(WordDB const &, ExperimentOpt const &, u64, OutputOpt const &);
+using BaselineFn = CaseResult (*)(ConcurrentNicknameSet const &, BlockedBloomFilter const *, WordDB const &,
+                                  ExperimentOpt const &, u64, CaseProgress &);
+
+struct ExperimentCase
+{
+    std::string_view name;
+    CaseFn run;
+    CaseFn run_sorted;
+    CaseFn run_shard;
+    ExportFn export_nicknames;
+    BaselineFn probe_baseline;
+};
+
+template <typename RandomEngine, EngineUsage USAGE>
+constexpr ExperimentCase make_experiment_case(std::string_view const name) noexcept
+{
+    return ExperimentCase{name,
+                          &run_case<RandomEngine, USAGE>,
+                          &run_sorted_case<RandomEngine, USAGE>,
+                          &run_shard_case<RandomEngine, USAGE>,
+                          &export_case<RandomEngine, USAGE>,
+                          &probe_baseline_case<RandomEngine, USAGE>};
+}
+
+// 32BIT, 64BIT는 각각 std::mt19937, std::mt19937_64를 사용하는 기존 실험이다.
+// RECREATE에서는 출력열이 같으면서 필요한 만큼만 초기화하는 LazyMt19937, LazyMt19937_64를 대신 사용한다.
+constexpr static auto EXPERIMENT_CASES = std::array{
+    make_experiment_case<std::mt19937, EngineUsage::REUSE>("REUSE/32BIT"),
+    make_experiment_case<std::mt19937_64, EngineUsage::REUSE>("REUSE/64BIT"),
+    make_experiment_case<LazyMt19937, EngineUsage::RECREATE>("RECREATE/32BIT"),
+    make_experiment_case<LazyMt19937_64, EngineUsage::RECREATE>("RECREATE/64BIT"),
+    make_experiment_case<SplitMix64, EngineUsage::REUSE>("REUSE/SPLITMIX64"),
+    make_experiment_case<Xoshiro256StarStar, EngineUsage::REUSE>("REUSE/XOSHIRO256SS"),
+    make_experiment_case<Pcg64, EngineUsage::REUSE>("REUSE/PCG64"),
+    make_experiment_case<Philox4x32, EngineUsage::REUSE>("REUSE/PHILOX4X32"),
+    make_experiment_case<SplitMix64, EngineUsage::RECREATE>("RECREATE/SPLITMIX64"),
+    make_experiment_case<Xoshiro256StarStar, EngineUsage::RECREATE>("RECREATE/XOSHIRO256SS"),
+    make_experiment_case<Pcg64, EngineUsage::RECREATE>("RECREATE/PCG64"),
+    make_experiment_case<Philox4x32, EngineUsage::RECREATE>("RECREATE/PHILOX4X32"),
+    make_experiment_case<Xoshiro256StarStar, EngineUsage::BATCH>("BATCH/XOSHIRO256SS"),
+};
+
+constexpr static auto DEFAULT_CASES = std::array<std::string_view, 4>{
+    "REUSE/32BIT",
+    "REUSE/64BIT",
+    "RECREATE/32BIT",
+    "RECREATE/64BIT",
+};
 
-    auto num_collisions = sz();
-    for (auto i = sz(); i < NUM_TRIES; ++i)
+WorkloadPreset const &find_workload_preset(std::string_view const name)
+{
+    auto const it = std::ranges::find(WORKLOAD_PRESETS, name, &WorkloadPreset::name);
+    if (it == std::ranges::cend(WORKLOAD_PRESETS))
     {
-        auto random_device = std::random_device();
-        auto pesudo_random_engine = std::mt19937_64(random_device());
-        auto const nickname = sample_nickname(pesudo_random_engine, word_db, SAMPLE_NICKNAME_OPT);
-        if (nickname_db.contains(nickname))
-        {
-            ++num_collisions;
-        }
+        throw std::invalid_argument("unknown preset: " + std::string(name));
     }
+    return *it;
+}
 
-    std::get<0>(out) = NUM_TRIES;
-    std::get<1>(out) = num_collisions;
-    std::get<2>(out) = static_cast<double>(num_collisions) / NUM_TRIES * 100;
+ExperimentCase const &find_experiment_case(std::string_view const name)
+{
+    auto const it = std::ranges::find(EXPERIMENT_CASES, name, &ExperimentCase::name);
+    if (it == std::ranges::cend(EXPERIMENT_CASES))
+    {
+        throw std::invalid_argument("unknown case: " + std::string(name));
+    }
+    return *it;
 }
 
 void print_about_expriment_env(WordDB const &word_db)
 {
     auto word_db_info = std::stringstream();
     word_db_info << "ENV: WORD DB { ";
-    for (auto i = sz(); i < word_db.size(); ++i)
+    for (auto i = sz(); i <= MAX_NICKNAME_LEN; ++i)
     {
         if (0 < i)
         {
             word_db_info << ", ";
         }
-        word_db_info << '[' << i << ']' << '=' << word_db[i].size();
+        word_db_info << '[' << i << ']' << '=' << word_db.num_words(i);
     }
     word_db_info << " }";
     spdlog::info(word_db_info.str());
 }
 
-int main([[maybe_unused]] int const argc, [[maybe_unused]] char const *const argv[])
+struct CaseRecord
+{
+    std::string_view case_name;
+    double mangling_factor;
+    CaseResult result;
+};
+
+// population_label은 결과 줄에서 집합의 크기 앞에 붙는 이름이다.
+void log_case_result(CaseRecord const &record, std::string_view const population_label, bool const filtered)
+{
+    auto const &[case_name, mangling_factor, result] = record;
+    spdlog::info("[{}] M = {}, {} = {}, 충돌 확률 = {}% ({}/{})", case_name, mangling_factor, population_label,
+                 result.num_initial_nicknames, result.collision_rate, result.num_collisions, result.num_tries);
+    if (0 < result.num_duplicates)
+    {
+        spdlog::info("[{}] 사전 생성 닉네임 중 중복 = {} (고유 {}개)", case_name, result.num_duplicates,
+                     result.num_initial_nicknames - result.num_duplicates);
+    }
+    if (filtered)
+    {
+        spdlog::info("[{}] 블룸 필터 오탐률 = {}%", case_name, result.filter_false_positive_rate);
+    }
+
+    auto phases = std::stringstream();
+    for (auto i = sz(); i < result.phases.size(); ++i)
+    {
+        auto const &phase = result.phases[i];
+        phases << (0 < i ? ", " : "") << phase.name << ' ' << phase.seconds << "s (" << phase.items_per_second()
+               << "/s, 할당 " << phase.num_allocations << "회)";
+    }
+    spdlog::info("[{}] {}, 적재율 = {}, 메모리 = {} MiB", case_name, phases.str(), result.load_factor,
+                 static_cast<double>(result.memory_usage) / (1 << 20));
+}
+
+// dir의 샤드 파일들을 실험별로 묶고, 파티션마다 모든 샤드의 키를 합쳐 정렬해 run_sorted_case와 같은 결과를 계산한다.
+// 샤드가 하나라도 빠지거나 겹치거나, 서로 다른 단어 목록으로 생성되었다면 std::exit를 호출한다. 결과는 EXPERIMENT_CASES의 순서, M, N 순으로 정렬한다.
+std::vector<CaseRecord> merge_shard_runs(std::filesystem::path const &dir, sz const num_threads)
 {
-    auto const word_db = [argc, argv]() {
-        return argc == 1 ? load_word_db(get_wordlist_txt_path().string()) : load_word_db(argv[1]);
-    }();
+    auto paths = std::vector<std::filesystem::path>();
+    auto ec = std::error_code();
+    for (auto const &entry : std::filesystem::directory_iterator(dir, ec))
+    {
+        if (entry.path().extension() == ".runs")
+        {
+            paths.push_back(entry.path());
+        }
+    }
+    if (ec)
+    {
+        spdlog::critical("failed to list shard runs: {}", dir.string());
+        std::exit(-1);
+    }
+    std::ranges::sort(paths);
 
+    auto const same_experiment = [](ShardRunsHeader const &a, ShardRunsHeader const &b) {
+        return a.num_shards == b.num_shards && a.seed == b.seed && a.stream == b.stream &&
+               a.nickname_opt == b.nickname_opt && a.num_initial_nicknames == b.num_initial_nicknames &&
+               a.num_tries == b.num_tries;
+    };
+    auto groups = std::vector<std::vector<ShardRuns>>();
+    for (auto const &path : paths)
+    {
+        auto runs = ShardRuns::open(path);
+        auto const it = std::ranges::find_if(
+            groups, [&](auto const &group) { return same_experiment(group.front().header(), runs.header()); });
+        if (it == groups.end())
+        {
+            groups.emplace_back().push_back(std::move(runs));
+        }
+        else if (it->front().header().num_words != runs.header().num_words ||
+                 it->front().header().word_db_fingerprint != runs.header().word_db_fingerprint)
+        {
+            spdlog::critical("shard runs generated from different word lists: {}, {}", it->front().path().string(),
+                             runs.path().string());
+            std::exit(-1);
+        }
+        else
+        {
+            it->push_back(std::move(runs));
+        }
+    }
+
+    auto const case_name = [](u64 const stream) {
+        auto const it = std::ranges::find_if(EXPERIMENT_CASES, [stream](auto const &test) {
+            return stream_id(test.name) == stream;
+        });
+        return it == std::ranges::cend(EXPERIMENT_CASES) ? std::string_view("UNKNOWN") : it->name;
+    };
+    auto const case_order = [](u64 const stream) {
+        return std::ranges::find_if(EXPERIMENT_CASES, [stream](auto const &test) {
+                   return stream_id(test.name) == stream;
+               }) - std::ranges::cbegin(EXPERIMENT_CASES);
+    };
+    std::ranges::sort(groups, {}, [&](auto const &group) {
+        auto const &header = group.front().header();
+        return std::tuple(case_order(header.stream), header.nickname_opt.mangling_factor,
+                          header.num_initial_nicknames);
+    });
+
+    auto records = std::vector<CaseRecord>();
+    for (auto &group : groups)
+    {
+        auto const &header = group.front().header();
+        std::ranges::sort(group, {}, [](auto const &runs) { return runs.header().shard_index; });
+        auto num_population_keys = sz();
+        auto num_probe_keys = sz();
+        for (auto i = sz(); i < group.size(); ++i)
+        {
+            if (group[i].header().shard_index != i)
+            {
+                break;
+            }
+            num_population_keys += group[i].header().num_population_keys;
+            num_probe_keys += group[i].header().num_probe_keys;
+        }
+        if (group.size() != header.num_shards || group.back().header().shard_index + 1 != header.num_shards ||
+            num_population_keys != header.num_initial_nicknames || num_probe_keys != header.num_tries)
+        {
+            spdlog::critical("incomplete shard runs: {} (expected {} shards, found {})",
+                             group.front().path().string(), header.num_shards, group.size());
+            std::exit(-1);
+        }
+
+        auto const merge_timer = PhaseTimer();
+        auto counts = std::vector<SortedKeyCounts>(KeyPartitions::NUM_PARTITIONS);
+        auto scratches = std::vector<std::vector<NicknameKey>>(num_threads);
+        parallel_for(num_threads, KeyPartitions::NUM_PARTITIONS, [&](sz const partition, sz const thread_idx) {
+            auto population_keys = std::vector<NicknameKey>();
+            auto probe_keys = std::vector<NicknameKey>();
+            for (auto const &runs : group)
+            {
+                runs.append_population(partition, population_keys);
+                runs.append_probes(partition, probe_keys);
+            }
+            radix_sort_keys(population_keys, scratches[thread_idx]);
+            radix_sort_keys(probe_keys, scratches[thread_idx]);
+            counts[partition] = count_sorted_keys(population_keys, probe_keys);
+        });
+
+        // 샤드 안의 중복은 기록할 때 제거되었으므로, 생성한 수와 합친 고유 키 수의 차이가 전체 중복 수다.
+        auto result = CaseResult{header.num_initial_nicknames, header.num_tries, 0, 0.0, 0.0, num_population_keys};
+        for (auto const &count : counts)
+        {
+            result.num_collisions += count.num_collisions;
+            result.num_duplicates -= count.num_unique;
+        }
+        result.collision_rate =
+            static_cast<double>(result.num_collisions) / static_cast<double>(header.num_tries) * 100;
+        result.phases = {merge_timer.finish("merge", num_population_keys + num_probe_keys)};
+        records.push_back(CaseRecord{case_name(header.stream), header.nickname_opt.mangling_factor, std::move(result)});
+    }
+    return records;
+}
+
+void write_case_records_json(std::ostream &out, std::vector<CaseRecord> const &records)
+{
+    out << "[\n";
+    for (auto i = sz(); i < records.size(); ++i)
+    {
+        auto const &[case_name, mangling_factor, result] = records[i];
+        out << "  {\"case\": ";
+        write_json_string(out, case_name);
+        out << ", \"mangling_factor\": " << mangling_factor
+            << ", \"num_initial_nicknames\": " << result.num_initial_nicknames
+            << ", \"num_tries\": " << result.num_tries << ", \"num_collisions\": " << result.num_collisions
+            << ", \"collision_rate\": " << result.collision_rate
+            << ", \"filter_false_positive_rate\": " << result.filter_false_positive_rate
+            << ", \"num_duplicates\": " << result.num_duplicates << ", \"load_factor\": " << result.load_factor
+            << ", \"memory_usage\": " << result.memory_usage << ", \"phases\": ";
+        write_json_phases(out, result.phases);
+        out << '}' << (i + 1 < records.size() ? "," : "") << '\n';
+    }
+    out << "]\n";
+}
+
+// 하나의 프로세스에서 (M, 사전 생성 닉네임 수, 케이스)의 모든 조합을 실행한다.
+struct CommandLineOpt
+{
+    std::string word_list_path;
+    std::vector<std::string_view> case_names;
+    std::vector<sz> num_initial_nicknames;
+    std::vector<double> mangling_factors;
+    bool incremental;
+    ExperimentOpt experiment;
+    OutputOpt output;
+    std::string baseline_path;
+    bool analytic;
+    bool sorted;
+    std::string json_path;
+    bool pin_threads;
+    double progress_interval;
+    bool sharded;
+    std::string merge_dir;
+};
+
+constexpr static auto USAGE = R"(usage: random-nickname-test [options] [word-list]
+
+options:
+  --word-list PATH          word list file (default: external/wordlist/wordlist-20210729.txt).
+                            the parsed list is cached in PATH.bin, which is loaded instead of
+                            PATH while it is newer
+  --cases LIST              comma separated case names (default: REUSE/32BIT,REUSE/64BIT,
+                            RECREATE/32BIT,RECREATE/64BIT). a case name is {REUSE|RECREATE}/ENGINE
+                            where ENGINE is one of 32BIT (mt19937), 64BIT (mt19937_64),
+                            SPLITMIX64, XOSHIRO256SS, PCG64 or PHILOX4X32. BATCH/XOSHIRO256SS
+                            generates packed nickname keys in batches without building strings
+                            (scalar code; about 2x REUSE)
+  --initial LIST            comma separated numbers of initial nicknames (default: 10000000)
+  --incremental             grow one nickname set through every --initial size in a single pass
+                            and check collisions at each size
+  --tries N                 number of collision checks, at least 1 (default: 50000000)
+  --min-len N               minimum nickname length (default: 8)
+  --max-len N               maximum nickname length (default: 8)
+  --min-word-len N          minimum word length (default: 3)
+  --max-word-len N          maximum word length (default: 8)
+  --mangling-factor LIST    comma separated mangling factors M (default: 2.7)
+  --threads N               maximum worker threads per case (default: hardware threads). all
+                            cases share one work-stealing pool of hardware threads, so threads
+                            freed by a finished case help the others
+  --bloom-bits N            check a blocked Bloom filter with N bits per nickname before the
+                            nickname set, and report its false positive rate (default: 0, off)
+  --reference-set           store nicknames as strings in a std::pmr::unordered_set over a
+                            huge-page monotonic arena instead of the packed key sets, as a
+                            reference for the original implementation. --sort and --baseline
+                            ignore it
+  --numa-replicate          copy the nickname set and the Bloom filter to every NUMA node before
+                            probing, so each probe chunk reads the copy on the node it runs on.
+                            uses one extra copy per node and does nothing on a single node.
+                            --reference-set is not copied
+  --pin-threads             pin each pool thread to one CPU, filling NUMA nodes in order
+                            (Linux only)
+  --progress SECONDS        log each case's set size, tries, running collision rate with its 95%
+                            Wilson interval and throughput every SECONDS (default: 0, off)
+  --precision R             stop probing once the 95% interval half-width of the collision rate
+                            is at most R times the estimate (e.g. 0.05 for +-5%) and report the
+                            tries done so far. the stop point depends only on the seed.
+                            --sort ignores it (default: 0, off)
+  --seed N                  master seed for reproducible results
+  --preset NAME             workload preset: full (10000000 initial, 50000000 tries), medium
+                            (1000000, 5000000), small (100000, 500000) or smoke (10000, 50000).
+                            the initial size is also the --count of --output. uses seed
+                            20210729 unless --seed is given, so runs are identical. later
+                            --initial, --tries and --count override it
+  --sort                    count exactly by sorting generated keys instead of using a hash set.
+                            the N initial nicknames are generated as is and their duplicates
+                            are reported. --bloom-bits is ignored
+  --spill-dir PATH          with --sort, keep key partitions in files under PATH instead of memory
+  --shard I/N               with --sort and --seed, generate only shard I of N (every N-th chunk
+                            from chunk I) and write its sorted packed-key runs to --shard-dir
+                            instead of counting. run every shard with the same options and word
+                            list, then combine them with --merge
+  --shard-dir PATH          directory for the shard runs files (default: current directory)
+  --merge DIR               merge every shard runs file in DIR into collision and duplicate
+                            counts equal to a single --sort run
+  --analytic                compute the collision rate of each --initial size from the word DB
+                            and the nickname options instead of sampling
+  --baseline PATH           check collisions against the nicknames in PATH (one per line, or a
+                            key file written by --format key) instead of generated ones.
+                            --initial and --incremental are ignored
+  --json PATH               also write every result with its phase timings, throughput, load
+                            factor, memory usage and allocation counts to PATH as JSON
+  --output PATH             write generated nicknames to PATH (- for stdout) instead of running
+                            the experiment. uses the first of --cases and --mangling-factor
+  --format FORMAT           output format: text (one per line), fixed (max-len bytes padded with
+                            NUL) or key (header and packed 64bit keys) (default: text)
+  --count N                 number of nicknames to write (default: 10000000)
+  --help                    print this message
+)";
+
+void validate_sample_nickname_opt(SampleNicknameOpt const &opt)
+{
+    if (opt.min_len == 0 || opt.max_len < opt.min_len || MAX_PACKED_NICKNAME_LEN < opt.max_len)
+    {
+        throw std::invalid_argument("nickname length must satisfy 1 <= min-len <= max-len <= " +
+                                    std::to_string(MAX_PACKED_NICKNAME_LEN));
+    }
+    if (opt.min_word_len == 0 || opt.max_word_len < opt.min_word_len || MAX_NICKNAME_LEN < opt.max_word_len)
+    {
+        throw std::invalid_argument("word length must satisfy 1 <= min-word-len <= max-word-len <= " +
+                                    std::to_string(MAX_NICKNAME_LEN));
+    }
+}
+
+CommandLineOpt parse_command_line(int const argc, char const *const argv[])
+{
+    auto opt = CommandLineOpt{
+        get_wordlist_txt_path().string(),
+        std::vector(std::ranges::cbegin(DEFAULT_CASES), std::ranges::cend(DEFAULT_CASES)),
+        {NUM_INITIAL_NICKNAMES},
+        {SAMPLE_NICKNAME_OPT.mangling_factor},
+        false,
+        ExperimentOpt{SAMPLE_NICKNAME_OPT, {}, NUM_TRIES, 0, std::nullopt, 0.0, {}, false, false, 0.0, 0, 1, "."},
+        OutputOpt{"", NicknameFormat::TEXT, NUM_INITIAL_NICKNAMES},
+        "",
+        false,
+        false,
+        "",
+        false,
+        0.0,
+        false,
+        "",
+    };
+    auto &nickname_opt = opt.experiment.nickname_opt;
+    auto preset_selected = false;
+    for (auto args = CommandLine(argc, argv); !args.empty();)
+    {
+        auto const arg = args.next();
+        if (arg == "--help" || arg == "-h")
+        {
+            std::cout << USAGE;
+            std::exit(EXIT_SUCCESS);
+        }
+        else if (arg == "--word-list")
+        {
+            opt.word_list_path = std::string(args.value(arg));
+        }
+        else if (arg == "--cases")
+        {
+            opt.case_names = split_list(args.value(arg));
+            std::ranges::for_each(opt.case_names, &find_experiment_case);
+        }
+        else if (arg == "--initial")
+        {
+            opt.num_initial_nicknames = parse_number_list<sz>(arg, args.value(arg));
+        }
+        else if (arg == "--incremental")
+        {
+            opt.incremental = true;
+        }
+        else if (arg == "--tries")
+        {
+            opt.experiment.num_tries = parse_number<sz>(arg, args.value(arg));
+            // 검사하지 않으면 충돌 확률을 정의할 수 없다.
+            if (opt.experiment.num_tries == 0)
+            {
+                throw std::invalid_argument("tries must be positive");
+            }
+        }
+        else if (arg == "--min-len")
+        {
+            nickname_opt.min_len = parse_number<sz>(arg, args.value(arg));
+        }
+        else if (arg == "--max-len")
+        {
+            nickname_opt.max_len = parse_number<sz>(arg, args.value(arg));
+        }
+        else if (arg == "--min-word-len")
+        {
+            nickname_opt.min_word_len = parse_number<sz>(arg, args.value(arg));
+        }
+        else if (arg == "--max-word-len")
+        {
+            nickname_opt.max_word_len = parse_number<sz>(arg, args.value(arg));
+        }
+        else if (arg == "--mangling-factor")
+        {
+            opt.mangling_factors = parse_number_list<double>(arg, args.value(arg));
+            if (std::ranges::any_of(opt.mangling_factors, [](auto const factor) { return !(0 < factor); }))
+            {
+                throw std::invalid_argument("mangling factor must be positive");
+            }
+        }
+        else if (arg == "--threads")
+        {
+            opt.experiment.num_threads = std::max(static_cast<sz>(1), parse_number<sz>(arg, args.value(arg)));
+        }
+        else if (arg == "--bloom-bits")
+        {
+            opt.experiment.bloom_bits_per_key = parse_number<double>(arg, args.value(arg));
+            if (opt.experiment.bloom_bits_per_key < 0)
+            {
+                throw std::invalid_argument("bloom filter bits per key must not be negative");
+            }
+        }
+        else if (arg == "--progress")
+        {
+            opt.progress_interval = parse_number<double>(arg, args.value(arg));
+            if (!(0 <= opt.progress_interval))
+            {
+                throw std::invalid_argument("progress interval must not be negative");
+            }
+        }
+        else if (arg == "--precision")
+        {
+            opt.experiment.target_precision = parse_number<double>(arg, args.value(arg));
+            if (!(0 <= opt.experiment.target_precision))
+            {
+                throw std::invalid_argument("precision must not be negative");
+            }
+        }
+        else if (arg == "--seed")
+        {
+            opt.experiment.seed = parse_number<u64>(arg, args.value(arg));
+        }
+        else if (arg == "--preset")
+        {
+            auto const &preset = find_workload_preset(args.value(arg));
+            opt.num_initial_nicknames = {preset.num_initial_nicknames};
+            opt.experiment.num_tries = preset.num_tries;
+            opt.output.num_nicknames = preset.num_initial_nicknames;
+            preset_selected = true;
+        }
+        else if (arg == "--json")
+        {
+            opt.json_path = args.value(arg);
+        }
+        else if (arg == "--reference-set")
+        {
+            opt.experiment.reference_set = true;
+        }
+        else if (arg == "--numa-replicate")
+        {
+            opt.experiment.numa_replicate = true;
+        }
+        else if (arg == "--pin-threads")
+        {
+            opt.pin_threads = true;
+        }
+        else if (arg == "--sort")
+        {
+            opt.sorted = true;
+        }
+        else if (arg == "--spill-dir")
+        {
+            opt.experiment.spill_dir = args.value(arg);
+        }
+        else if (arg == "--shard")
+        {
+            auto const value = args.value(arg);
+            auto const slash = value.find('/');
+            if (slash == std::string_view::npos)
+            {
+                throw std::invalid_argument("shard must be I/N");
+            }
+            opt.experiment.shard_index = parse_number<sz>(arg, value.substr(0, slash));
+            opt.experiment.num_shards = parse_number<sz>(arg, value.substr(slash + 1));
+            if (opt.experiment.num_shards <= opt.experiment.shard_index)
+            {
+                throw std::invalid_argument("shard must satisfy 0 <= I < N");
+            }
+            opt.sharded = true;
+        }
+        else if (arg == "--shard-dir")
+        {
+            opt.experiment.shard_dir = args.value(arg);
+        }
+        else if (arg == "--merge")
+        {
+            opt.merge_dir = args.value(arg);
+        }
+        else if (arg == "--analytic")
+        {
+            opt.analytic = true;
+        }
+        else if (arg == "--baseline")
+        {
+            opt.baseline_path = args.value(arg);
+        }
+        else if (arg == "--output")
+        {
+            opt.output.path = args.value(arg);
+        }
+        else if (arg == "--format")
+        {
+            opt.output.format = parse_nickname_format(args.value(arg));
+        }
+        else if (arg == "--count")
+        {
+            opt.output.num_nicknames = parse_number<sz>(arg, args.value(arg));
+        }
+        else if (arg.starts_with("--"))
+        {
+            throw std::invalid_argument("unknown option: " + std::string(arg));
+        }
+        else
+        {
+            opt.word_list_path = std::string(arg);
+        }
+    }
+
+    if (preset_selected && !opt.experiment.seed)
+    {
+        opt.experiment.seed = PRESET_SEED;
+    }
+    validate_sample_nickname_opt(nickname_opt);
+    if (opt.sorted && opt.incremental)
+    {
+        throw std::invalid_argument("--sort cannot be combined with --incremental");
+    }
+    if (opt.sharded && (!opt.sorted || !opt.experiment.seed))
+    {
+        throw std::invalid_argument("--shard requires --sort and --seed");
+    }
+    if (opt.experiment.num_threads == 0)
+    {
+        opt.experiment.num_threads = thread_pool().num_threads();
+    }
+    return opt;
+}
+
+int main(int const argc, char const *const argv[])
+{
+    auto opt = CommandLineOpt();
+    try
+    {
+        opt = parse_command_line(argc, argv);
+    }
+    catch (std::invalid_argument const &e)
+    {
+        spdlog::critical(e.what());
+        std::cerr << USAGE;
+        return EXIT_FAILURE;
+    }
+
+    // 닉네임을 표준 출력에 기록할 때는 로그가 섞이지 않도록 표준 에러로 옮긴다.
+    if (opt.output.path == "-")
+    {
+        spdlog::set_default_logger(
+            std::make_shared<spdlog::logger>("", std::make_shared<spdlog::sinks::stderr_color_sink_mt>()));
+    }
+
+    auto const write_json = [&opt](std::vector<CaseRecord> const &records) {
+        if (opt.json_path.empty())
+        {
+            return;
+        }
+        auto f = std::ofstream(opt.json_path);
+        write_case_records_json(f, records);
+        if (!f.flush())
+        {
+            spdlog::critical("failed to write json: {}", opt.json_path);
+            std::exit(-1);
+        }
+    };
+
+    // 샤드 파일만으로 결과를 계산하므로 단어 목록을 읽지 않는다.
+    if (!opt.merge_dir.empty())
+    {
+        auto const records = merge_shard_runs(opt.merge_dir, opt.experiment.num_threads);
+        for (auto const &record : records)
+        {
+            log_case_result(record, "사전 생성 닉네임 수", false);
+        }
+        write_json(records);
+        return EXIT_SUCCESS;
+    }
+
+    auto const word_db = load_word_db(opt.word_list_path);
     print_about_expriment_env(word_db);
+    if (opt.experiment.numa_replicate || opt.pin_threads)
+    {
+        spdlog::info("ENV: NUMA 노드 {}개, CPU {}개", numa_topology().num_nodes(), numa_topology().num_cpus());
+    }
+    if (opt.pin_threads && !pin_thread_pool(thread_pool()))
+    {
+        spdlog::warn("failed to pin threads to cpus");
+    }
+    if (opt.experiment.seed)
+    {
+        spdlog::info("ENV: SEED {}", *opt.experiment.seed);
+    }
+
+    auto const &nickname_opt = opt.experiment.nickname_opt;
+    for (auto chance = nickname_opt.min_word_len; chance <= nickname_opt.max_len; ++chance)
+    {
+        if (word_db.num_words(nickname_opt.min_word_len, std::min(nickname_opt.max_word_len, chance)) == 0)
+        {
+            spdlog::critical("there are no words of length [{}, {}]", nickname_opt.min_word_len,
+                             std::min(nickname_opt.max_word_len, chance));
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!opt.output.path.empty())
+    {
+        auto experiment_opt = opt.experiment;
+        experiment_opt.nickname_opt.mangling_factor = opt.mangling_factors.front();
+        auto const &test = find_experiment_case(opt.case_names.front());
+        test.export_nicknames(word_db, experiment_opt, stream_id(test.name), opt.output);
+        spdlog::info("[{}] M = {}, 닉네임 {}개를 {}에 기록", test.name, experiment_opt.nickname_opt.mangling_factor,
+                     opt.output.num_nicknames, opt.output.path);
+        return EXIT_SUCCESS;
+    }
+
+    // 사전 생성된 닉네임 N개 중 하나와 충돌할 확률은 1 - (1 - sum p(x)^2)^N으로 근사한다.
+    if (opt.analytic)
+    {
+        for (auto const mangling_factor : opt.mangling_factors)
+        {
+            auto nickname_opt = opt.experiment.nickname_opt;
+            nickname_opt.mangling_factor = mangling_factor;
+            auto const collision_probability =
+                nickname_collision_probability(word_db, nickname_opt, opt.experiment.num_threads);
+            auto const recreate_collision_probability =
+                collision_probability + (1 - collision_probability) * std::ldexp(1.0, -RECREATE_SEED_BITS);
+            spdlog::info("[ANALYTIC] M = {}, sum p^2 = {}", mangling_factor, collision_probability);
+            for (auto const num_initial_nicknames : opt.num_initial_nicknames)
+            {
+                auto const reuse = population_collision_probability(collision_probability, num_initial_nicknames);
+                auto const recreate =
+                    population_collision_probability(recreate_collision_probability, num_initial_nicknames);
+                spdlog::info("[ANALYTIC] M = {}, 사전 생성 닉네임 수 = {}, 예상 충돌 확률 ≈ {}% (REUSE), {}% (RECREATE), "
+                             "예상 충돌 수 ≈ {} / {} (REUSE)",
+                             mangling_factor, num_initial_nicknames, reuse * 100, recreate * 100,
+                             reuse * static_cast<double>(opt.experiment.num_tries), opt.experiment.num_tries);
+            }
+        }
+        return EXIT_SUCCESS;
+    }
+
+    auto records = std::vector<CaseRecord>();
+
+    // 각 케이스는 모든 측정 지점에서 같은 진행 상황을 이어서 사용한다.
+    auto progress = std::vector<CaseProgress>(opt.case_names.size());
+    for (auto i = sz(); i < opt.case_names.size(); ++i)
+    {
+        progress[i].name = opt.case_names[i];
+    }
+    auto const reporter = ProgressReporter(progress, std::chrono::duration<double>(opt.progress_interval));
 
-    auto const tests = std::vector{{
-        std::pair{&case01, "REUSE/32BIT"},
-        std::pair{&case03, "REUSE/64BIT"},
-        std::pair{&case02, "RECREATE/32BIT"},
-        std::pair{&case04, "RECREATE/64BIT"},
-    }};
-    auto test_results = std::vector<std::tuple<sz, sz, double>>(tests.size(), {0, 0, 0.0});
+    if (!opt.baseline_path.empty())
     {
-        auto testers = std::vector<std::thread>();
-        for (auto i = sz(); i < tests.size(); ++i)
+        auto const load_timer = PhaseTimer();
+        auto const dump = map_nickname_dump(opt.baseline_path, opt.experiment.num_threads);
+        auto nickname_db = ConcurrentNicknameSet(dump.num_records);
+        auto filter = make_prefilter(opt.experiment, dump.num_records);
+        auto const num_skipped = insert_nickname_dump(dump, opt.experiment.num_threads, [&](NicknameKey const key) {
+            if (nickname_db.insert(key) && filter)
+            {
+                filter->insert(key);
+            }
+        });
+        auto const load_stats = load_timer.finish("load", dump.num_records);
+        spdlog::info("기존 닉네임 {}개 (중복 제외), 생성할 수 없는 닉네임 {}개 제외", nickname_db.size(), num_skipped);
+
+        for (auto const mangling_factor : opt.mangling_factors)
         {
-            testers.emplace_back(std::thread(tests[i].first, std::ref(word_db), std::ref(test_results[i])));
+            auto experiment_opt = opt.experiment;
+            experiment_opt.nickname_opt.mangling_factor = mangling_factor;
+            auto results = std::vector<CaseResult>(opt.case_names.size());
+            {
+                auto testers = TaskGroup();
+                for (auto i = sz(); i < opt.case_names.size(); ++i)
+                {
+                    testers.run([&, i]() {
+                        auto const &test = find_experiment_case(opt.case_names[i]);
+                        results[i] = test.probe_baseline(nickname_db, filter ? &*filter : nullptr, word_db,
+                                                         experiment_opt, stream_id(test.name), progress[i]);
+                    });
+                }
+                testers.wait();
+            }
+            for (auto i = sz(); i < opt.case_names.size(); ++i)
+            {
+                results[i].phases.insert(results[i].phases.begin(), load_stats);
+                records.push_back(CaseRecord{opt.case_names[i], mangling_factor, std::move(results[i])});
+                log_case_result(records.back(), "기존 닉네임 수", filter.has_value());
+            }
         }
-        std::ranges::for_each(testers, &std::thread::join);
+        write_json(records);
+        return EXIT_SUCCESS;
+    }
+
+    // 점진적 실험에서는 모든 크기를 하나의 집합으로 처리하고, 그렇지 않다면 크기마다 집합을 새로 생성한다.
+    auto population_checkpoints = std::vector<std::vector<sz>>();
+    if (opt.incremental)
+    {
+        auto checkpoints = opt.num_initial_nicknames;
+        std::ranges::sort(checkpoints);
+        population_checkpoints.push_back(std::move(checkpoints));
+    }
+    else
+    {
+        std::ranges::transform(opt.num_initial_nicknames, std::back_inserter(population_checkpoints),
+                               [](auto const num_initial_nicknames) { return std::vector{num_initial_nicknames}; });
     }
-    for (auto i = sz(); i < tests.size(); ++i)
+
+    for (auto const mangling_factor : opt.mangling_factors)
     {
-        spdlog::info("[{}] 충돌 확률 = {}% ({}/{})", tests[i].second, std::get<2>(test_results[i]),
-                     std::get<1>(test_results[i]), std::get<0>(test_results[i]));
+        for (auto const &checkpoints : population_checkpoints)
+        {
+            auto experiment_opt = opt.experiment;
+            experiment_opt.nickname_opt.mangling_factor = mangling_factor;
+            experiment_opt.population_checkpoints = checkpoints;
+
+            auto test_results = std::vector<std::vector<CaseResult>>(opt.case_names.size());
+            {
+                auto testers = TaskGroup();
+                for (auto i = sz(); i < opt.case_names.size(); ++i)
+                {
+                    auto const &test = find_experiment_case(opt.case_names[i]);
+                    auto const run = opt.sharded ? test.run_shard : opt.sorted ? test.run_sorted : test.run;
+                    testers.run([&, i, run, stream = stream_id(test.name)]() {
+                        run(word_db, experiment_opt, stream, progress[i], test_results[i]);
+                    });
+                }
+                // 정렬 모드의 파티션 파일을 쓰거나 읽지 못한 경우
+                try
+                {
+                    testers.wait();
+                }
+                catch (std::runtime_error const &e)
+                {
+                    spdlog::critical(e.what());
+                    return EXIT_FAILURE;
+                }
+            }
+            // 샤드 모드의 결과는 --merge에서 계산한다.
+            if (opt.sharded)
+            {
+                continue;
+            }
+            for (auto checkpoint = sz(); checkpoint < checkpoints.size(); ++checkpoint)
+            {
+                for (auto i = sz(); i < opt.case_names.size(); ++i)
+                {
+                    records.push_back(
+                        CaseRecord{opt.case_names[i], mangling_factor, std::move(test_results[i][checkpoint])});
+                    log_case_result(records.back(), "사전 생성 닉네임 수",
+                                    !opt.sorted && 0 < experiment_opt.bloom_bits_per_key);
+                }
+            }
+        }
     }
+    write_json(records);
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "types.h"
+
+// 읽기 전용으로 메모리에 매핑한 파일. 내용을 복사하지 않고 string_view로 바로 읽는다.
+class MappedFile
+{
+  public:
+    MappedFile() noexcept = default;
+
+    MappedFile(MappedFile &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile &operator=(MappedFile const &) = delete;
+
+    ~MappedFile()
+    {
+        unmap();
+    }
+
+    // 파일을 열 수 없거나 매핑에 실패하면 std::nullopt를 돌려준다. 빈 파일은 빈 매핑이 된다.
+    static std::optional<MappedFile> open(std::filesystem::path const &path) noexcept
+    {
+        auto file = MappedFile();
+#if defined(_WIN32)
+        auto const handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            return std::nullopt;
+        }
+        auto size = LARGE_INTEGER();
+        if (!GetFileSizeEx(handle, &size))
+        {
+            CloseHandle(handle);
+            return std::nullopt;
+        }
+        if (size.QuadPart > 0)
+        {
+            auto const mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr)
+            {
+                file.data_ = static_cast<char const *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+            if (file.data_ == nullptr)
+            {
+                CloseHandle(handle);
+                return std::nullopt;
+            }
+            file.size_ = static_cast<sz>(size.QuadPart);
+        }
+        CloseHandle(handle);
+#else
+        auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return std::nullopt;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            return std::nullopt;
+        }
+        if (st.st_size > 0)
+        {
+            auto *const data = mmap(nullptr, static_cast<sz>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                close(fd);
+                return std::nullopt;
+            }
+            madvise(data, static_cast<sz>(st.st_size), MADV_SEQUENTIAL);
+            file.data_ = static_cast<char const *>(data);
+            file.size_ = static_cast<sz>(st.st_size);
+        }
+        close(fd);
+#endif
+        return file;
+    }
+
+    char const *data() const noexcept
+    {
+        return data_;
+    }
+
+    sz size() const noexcept
+    {
+        return size_;
+    }
+
+    std::string_view view() const noexcept
+    {
+        return std::string_view(data_, size_);
+    }
+
+  private:
+    void unmap() noexcept
+    {
+        if (data_ == nullptr)
+        {
+            return;
+        }
+#if defined(_WIN32)
+        UnmapViewOfFile(data_);
+#else
+        munmap(const_cast<char *>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    char const *data_ = nullptr;
+    sz size_ = 0;
+};
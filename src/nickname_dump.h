@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "mapped_file.h"
+#include "nickname_key.h"
+#include "nickname_output.h"
+#include "parallel.h"
+#include "types.h"
+#include "word_db.h"
+
+// 기존 닉네임 덤프를 매핑한 것. KEY 형식이라면 keys를, 텍스트라면 줄 경계로 나눈 text_parts를 사용한다.
+// num_records는 KEY 형식에서는 키의 개수, 텍스트에서는 줄 수의 상한이다.
+struct NicknameDump
+{
+    MappedFile file;
+    std::span<NicknameKey const> keys;
+    std::vector<std::string_view> text_parts;
+    sz num_records = 0;
+};
+
+// text를 대략 같은 크기의 num_parts개 조각으로 나누되, 각 조각이 줄의 시작에서 시작하도록 경계를 옮긴다.
+inline std::vector<std::string_view> split_lines(std::string_view const text, sz const num_parts)
+{
+    auto parts = std::vector<std::string_view>();
+    auto begin = sz();
+    for (auto i = static_cast<sz>(1); i <= num_parts && begin < text.size(); ++i)
+    {
+        auto end = i == num_parts ? text.size() : std::max(begin, text.size() / num_parts * i);
+        if (end < text.size())
+        {
+            auto const newline = text.find('\n', end);
+            end = newline == std::string_view::npos ? text.size() : newline + 1;
+        }
+        parts.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return parts;
+}
+
+// 파일이 NicknameKeyFileHeader로 시작하면 KEY 형식으로, 아니라면 한 줄에 닉네임 하나인 텍스트로 읽는다.
+inline NicknameDump map_nickname_dump(std::filesystem::path const &path, sz const num_threads)
+{
+    auto file = MappedFile::open(path);
+    if (!file)
+    {
+        spdlog::critical("failed to open nickname dump: {}", path.string());
+        std::exit(-1);
+    }
+
+    auto dump = NicknameDump();
+    auto const data = file->view();
+    auto header = NicknameKeyFileHeader();
+    if (sizeof(header) <= data.size())
+    {
+        std::memcpy(&header, data.data(), sizeof(header));
+    }
+    if (sizeof(header) <= data.size() && header.magic == NICKNAME_KEY_FILE_MAGIC)
+    {
+        if (header.version != NICKNAME_KEY_FILE_VERSION ||
+            (data.size() - sizeof(header)) / sizeof(NicknameKey) < header.num_keys)
+        {
+            spdlog::critical("corrupted nickname key file: {}", path.string());
+            std::exit(-1);
+        }
+        dump.keys = std::span(reinterpret_cast<NicknameKey const *>(data.data() + sizeof(header)),
+                              static_cast<sz>(header.num_keys));
+        dump.num_records = dump.keys.size();
+    }
+    else
+    {
+        dump.text_parts = split_lines(data, num_threads * 16);
+        auto line_counts = std::vector<PaddedCounter>(dump.text_parts.size());
+        parallel_for(num_threads, dump.text_parts.size(), [&](sz const part, sz) {
+            auto const &text = dump.text_parts[part];
+            line_counts[part].value = static_cast<sz>(std::ranges::count(text, '\n')) + (text.ends_with('\n') ? 0 : 1);
+        });
+        for (auto const &counter : line_counts)
+        {
+            dump.num_records += counter.value;
+        }
+    }
+    dump.file = std::move(*file);
+    return dump;
+}
+
+// 따옴표로 감싼 줄도 받아들인다. 생성기가 만들 수 없는 닉네임(길이가 MAX_PACKED_NICKNAME_LEN을 넘거나
+// 닉네임 문자가 아닌 문자를 포함)은 충돌할 수 없으므로 EMPTY_NICKNAME_KEY를 돌려 건너뛰게 한다.
+inline NicknameKey parse_nickname_line(std::string_view line) noexcept
+{
+    if (2 <= line.length() && line.front() == '"' && line.back() == '"')
+    {
+        line = line.substr(1, line.length() - 2);
+    }
+    if (line.empty() || MAX_PACKED_NICKNAME_LEN < line.length() || !std::ranges::all_of(line, &is_nickname_symbol))
+    {
+        return EMPTY_NICKNAME_KEY;
+    }
+    return pack_nickname(line);
+}
+
+// 덤프의 모든 닉네임에 대해 여러 스레드에서 동시에 insert_key(key)를 호출하고, 건너뛴 레코드의 수를 돌려준다.
+template <typename InsertKey>
+sz insert_nickname_dump(NicknameDump const &dump, sz const num_threads, InsertKey &&insert_key)
+{
+    constexpr static auto KEYS_PER_TASK = static_cast<sz>(1 << 16);
+
+    auto num_skipped = std::vector<PaddedCounter>(num_threads);
+    auto const insert = [&](NicknameKey const key, sz const thread_idx) {
+        if (key == EMPTY_NICKNAME_KEY)
+        {
+            ++num_skipped[thread_idx].value;
+        }
+        else
+        {
+            insert_key(key);
+        }
+    };
+
+    if (!dump.keys.empty())
+    {
+        parallel_for(num_threads, (dump.keys.size() + KEYS_PER_TASK - 1) / KEYS_PER_TASK,
+                     [&](sz const task, sz const thread_idx) {
+                         for (auto const key : dump.keys.subspan(task * KEYS_PER_TASK,
+                                                                 std::min(KEYS_PER_TASK, dump.keys.size() - task * KEYS_PER_TASK)))
+                         {
+                             insert(key, thread_idx);
+                         }
+                     });
+    }
+    else
+    {
+        parallel_for(num_threads, dump.text_parts.size(), [&](sz const part, sz const thread_idx) {
+            for_each_line(dump.text_parts[part], [&](std::string_view const line) {
+                if (!line.empty())
+                {
+                    insert(parse_nickname_line(line), thread_idx);
+                }
+            });
+        });
+    }
+
+    auto total = sz();
+    for (auto const &counter : num_skipped)
+    {
+        total += counter.value;
+    }
+    return total;
+}
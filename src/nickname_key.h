@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+
+#include "types.h"
+
+// 닉네임의 각 문자를 6비트 심볼(0..9 → 1..10, A..Z → 11..36, a..z → 37..62)로 변환해 64비트 정수에 채워 넣는다.
+// 심볼 0은 문자열의 끝을 의미하므로 빈 문자열이 아닌 닉네임의 키는 0이 될 수 없으며, 해시 테이블은 0을 빈 슬롯으로 사용한다.
+using NicknameKey = u64;
+
+constexpr static auto NICKNAME_SYMBOL_BITS = 6;
+constexpr static auto MAX_PACKED_NICKNAME_LEN = static_cast<sz>(64 / NICKNAME_SYMBOL_BITS);
+constexpr static auto EMPTY_NICKNAME_KEY = static_cast<NicknameKey>(0);
+
+constexpr static auto NICKNAME_SYMBOLS =
+    std::string_view("0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz");
+
+constexpr static auto NICKNAME_SYMBOL_CODES = []() {
+    auto codes = std::array<u8, 256>();
+    for (auto i = sz(); i < NICKNAME_SYMBOLS.length(); ++i)
+    {
+        codes[static_cast<u8>(NICKNAME_SYMBOLS[i])] = static_cast<u8>(i + 1);
+    }
+    return codes;
+}();
+
+constexpr bool is_nickname_symbol(char const ch) noexcept
+{
+    return NICKNAME_SYMBOL_CODES[static_cast<u8>(ch)] != 0;
+}
+
+// nickname은 MAX_PACKED_NICKNAME_LEN 이하의 길이를 가지며, 모든 문자가 is_nickname_symbol을 만족해야 한다.
+constexpr NicknameKey pack_nickname(std::string_view const nickname) noexcept
+{
+    auto key = NicknameKey();
+    for (auto i = sz(); i < nickname.length(); ++i)
+    {
+        key |= static_cast<NicknameKey>(NICKNAME_SYMBOL_CODES[static_cast<u8>(nickname[i])])
+               << (i * NICKNAME_SYMBOL_BITS);
+    }
+    return key;
+}
+
+constexpr sz unpack_nickname(NicknameKey key, char *const out) noexcept
+{
+    auto length = sz();
+    for (; key != 0; key >>= NICKNAME_SYMBOL_BITS)
+    {
+        out[length++] = NICKNAME_SYMBOLS[(key & ((1 << NICKNAME_SYMBOL_BITS) - 1)) - 1];
+    }
+    return length;
+}
+
+// MurmurHash3의 64비트 finalizer
+constexpr u64 hash_nickname_key(NicknameKey key) noexcept
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
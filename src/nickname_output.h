@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include <spdlog/spdlog.h>
+
+#include "nickname_key.h"
+#include "types.h"
+
+// TEXT는 한 줄에 닉네임 하나, FIXED는 max_len바이트로 '\0'을 채운 레코드, KEY는 NicknameKey를 그대로 기록한다.
+enum class NicknameFormat
+{
+    TEXT,
+    FIXED,
+    KEY,
+};
+
+inline NicknameFormat parse_nickname_format(std::string_view const name)
+{
+    if (name == "text")
+    {
+        return NicknameFormat::TEXT;
+    }
+    if (name == "fixed")
+    {
+        return NicknameFormat::FIXED;
+    }
+    if (name == "key")
+    {
+        return NicknameFormat::KEY;
+    }
+    throw std::invalid_argument("unknown output format: " + std::string(name));
+}
+
+// KEY 형식의 파일은 이 헤더로 시작하며, 뒤에 num_keys개의 NicknameKey가 기계의 바이트 순서로 이어진다.
+struct NicknameKeyFileHeader
+{
+    std::array<char, 8> magic;
+    u32 version;
+    u32 reserved;
+    u64 num_keys;
+};
+
+constexpr static auto NICKNAME_KEY_FILE_MAGIC = std::array{'N', 'I', 'C', 'K', 'K', 'E', 'Y', 'S'};
+constexpr static auto NICKNAME_KEY_FILE_VERSION = static_cast<u32>(1);
+
+constexpr sz nickname_record_size(NicknameFormat const format, sz const max_len) noexcept
+{
+    switch (format)
+    {
+    case NicknameFormat::TEXT:
+        return max_len + 1;
+    case NicknameFormat::FIXED:
+        return max_len;
+    default:
+        return sizeof(NicknameKey);
+    }
+}
+
+// out의 용량이 충분하다면 재할당 없이 레코드 하나를 덧붙인다.
+inline void append_nickname_record(NicknameFormat const format, sz const max_len, NicknameKey const key,
+                                   std::vector<char> &out)
+{
+    auto const pos = out.size();
+    out.resize(pos + nickname_record_size(format, max_len));
+    auto *const record = out.data() + pos;
+    switch (format)
+    {
+    case NicknameFormat::TEXT: {
+        auto const len = unpack_nickname(key, record);
+        record[len] = '\n';
+        out.resize(pos + len + 1);
+        break;
+    }
+    case NicknameFormat::FIXED: {
+        auto const len = unpack_nickname(key, record);
+        std::memset(record + len, 0, max_len - len);
+        break;
+    }
+    default:
+        std::memcpy(record, &key, sizeof(key));
+        break;
+    }
+}
+
+// path가 "-"라면 표준 출력에 기록한다. 레코드는 호출자가 모아 둔 큰 버퍼 단위로만 기록하며, 실패하면 종료한다.
+class NicknameWriter
+{
+  public:
+    explicit NicknameWriter(std::string const &path)
+    {
+        if (path == "-")
+        {
+#if defined(_WIN32)
+            _setmode(_fileno(stdout), _O_BINARY);
+#endif
+            file_ = stdout;
+        }
+        else
+        {
+            file_ = std::fopen(path.c_str(), "wb");
+            if (file_ == nullptr)
+            {
+                spdlog::critical("failed to open output file: {}", path);
+                std::exit(-1);
+            }
+        }
+        std::setvbuf(file_, nullptr, _IONBF, 0);
+    }
+
+    NicknameWriter(NicknameWriter const &) = delete;
+    NicknameWriter &operator=(NicknameWriter const &) = delete;
+
+    ~NicknameWriter()
+    {
+        if (file_ != stdout)
+        {
+            std::fclose(file_);
+        }
+    }
+
+    void write(void const *const data, sz const size)
+    {
+        if (std::fwrite(data, 1, size, file_) != size)
+        {
+            spdlog::critical("failed to write nicknames");
+            std::exit(-1);
+        }
+    }
+
+    void write_key_file_header(sz const num_keys)
+    {
+        auto const header =
+            NicknameKeyFileHeader{NICKNAME_KEY_FILE_MAGIC, NICKNAME_KEY_FILE_VERSION, 0, static_cast<u64>(num_keys)};
+        write(&header, sizeof(header));
+    }
+
+    void flush()
+    {
+        if (std::fflush(file_) != 0)
+        {
+            spdlog::critical("failed to write nicknames");
+            std::exit(-1);
+        }
+    }
+
+  private:
+    std::FILE *file_ = nullptr;
+};
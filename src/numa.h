@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <concepts>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "parallel.h"
+#include "types.h"
+
+// NUMA 노드별 CPU 목록
+// Linux에서는 /sys/devices/system/node에서 읽는다. 다른 플랫폼이거나 읽을 수 없다면 모든 CPU가 노드 하나에 있다.
+struct NumaTopology
+{
+    std::vector<std::vector<sz>> node_cpus;
+    std::vector<sz> cpu_nodes;
+
+    sz num_nodes() const noexcept
+    {
+        return node_cpus.size();
+    }
+
+    sz num_cpus() const noexcept
+    {
+        return cpu_nodes.size();
+    }
+
+    // 노드 순서로 나열한 CPU 중 idx번째
+    sz cpu(sz idx) const noexcept
+    {
+        idx %= num_cpus();
+        for (auto const &cpus : node_cpus)
+        {
+            if (idx < cpus.size())
+            {
+                return cpus[idx];
+            }
+            idx -= cpus.size();
+        }
+        return 0;
+    }
+};
+
+// "0-3,8-11" 형식의 CPU 목록을 읽는다. 형식이 맞지 않다면 빈 목록을 반환한다.
+inline std::vector<sz> parse_cpu_list(std::string_view const list)
+{
+    auto cpus = std::vector<sz>();
+    auto const parse = [](std::string_view const str, sz &value) {
+        auto const [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+        return ec == std::errc() && ptr == str.data() + str.size();
+    };
+    for (auto begin = sz(); begin < list.size();)
+    {
+        auto const end = std::min(list.find(',', begin), list.size());
+        auto const range = list.substr(begin, end - begin);
+        auto const dash = range.find('-');
+        auto first = sz();
+        auto last = sz();
+        if (!parse(range.substr(0, dash), first) ||
+            !parse(dash == std::string_view::npos ? range : range.substr(dash + 1), last) || last < first)
+        {
+            return {};
+        }
+        for (auto cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+        begin = end + 1;
+    }
+    return cpus;
+}
+
+inline NumaTopology detect_numa_topology()
+{
+    auto topology = NumaTopology();
+#if defined(__linux__)
+    auto const root = std::filesystem::path("/sys/devices/system/node");
+    for (auto node = sz();; ++node)
+    {
+        auto f = std::ifstream(root / ("node" + std::to_string(node)) / "cpulist");
+        auto list = std::string();
+        if (!f || !std::getline(f, list))
+        {
+            break;
+        }
+        auto cpus = parse_cpu_list(list);
+        if (cpus.empty())
+        {
+            // CPU가 없는 메모리 전용 노드는 조회 스레드가 놓일 수 없으므로 건너뛴다.
+            continue;
+        }
+        for (auto const cpu : cpus)
+        {
+            topology.cpu_nodes.resize(std::max(topology.cpu_nodes.size(), cpu + 1));
+            topology.cpu_nodes[cpu] = topology.node_cpus.size();
+        }
+        topology.node_cpus.push_back(std::move(cpus));
+    }
+#endif
+    if (topology.node_cpus.empty())
+    {
+        auto const num_cpus = static_cast<sz>(std::max(static_cast<unsigned>(1), std::thread::hardware_concurrency()));
+        topology.node_cpus.emplace_back(num_cpus);
+        for (auto cpu = sz(); cpu < num_cpus; ++cpu)
+        {
+            topology.node_cpus[0][cpu] = cpu;
+        }
+        topology.cpu_nodes.assign(num_cpus, 0);
+    }
+    return topology;
+}
+
+// 처음 사용할 때 한 번 읽는 이 프로세스의 노드 구성
+inline NumaTopology const &numa_topology()
+{
+    static auto const topology = detect_numa_topology();
+    return topology;
+}
+
+// 호출한 스레드가 지금 실행 중인 노드. 알 수 없다면 0이다.
+inline sz current_numa_node()
+{
+#if defined(__linux__)
+    auto const &topology = numa_topology();
+    auto const cpu = sched_getcpu();
+    if (0 <= cpu && static_cast<sz>(cpu) < topology.num_cpus())
+    {
+        return topology.cpu_nodes[static_cast<sz>(cpu)];
+    }
+#endif
+    return 0;
+}
+
+#if defined(__linux__)
+inline bool pin_thread(pthread_t const thread, sz const cpu)
+{
+    auto cpus = cpu_set_t();
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return pthread_setaffinity_np(thread, sizeof(cpus), &cpus) == 0;
+}
+#endif
+
+// 풀의 작업자와 호출한 스레드를 노드 순서로 나열한 CPU에 하나씩 고정한다. 작업자가 CPU보다 많다면 처음부터 다시
+// 나누어 준다. 고정하지 못한 스레드가 있거나 지원하지 않는 플랫폼이라면 false를 반환한다.
+inline bool pin_thread_pool(ThreadPool &pool)
+{
+#if defined(__linux__)
+    auto const &topology = numa_topology();
+    auto pinned = true;
+    auto idx = sz();
+    pool.for_each_worker(
+        [&](std::thread &worker) { pinned = pin_thread(worker.native_handle(), topology.cpu(idx++)) && pinned; });
+    return pin_thread(pthread_self(), topology.cpu(idx)) && pinned;
+#else
+    static_cast<void>(pool);
+    return false;
+#endif
+}
+
+// 읽기 전용 객체의 노드별 복제본
+// 복제본은 그 노드에서 처음 local()을 호출한 스레드가 복사해 만들므로, first-touch 정책에 따라 그 노드의 메모리에
+// 놓인다. 노드가 하나이거나 복사할 수 없는 타입이라면 원본을 그대로 쓴다.
+// 복제본이 있는 동안 원본을 바꾸어서는 안 되며, local()은 여러 스레드에서 동시에 호출할 수 있다.
+template <typename T>
+class NumaReplicas
+{
+  public:
+    NumaReplicas(T const &original, bool const enabled)
+        : original_(original), num_nodes_(enabled && std::copy_constructible<T> ? numa_topology().num_nodes() : 1),
+          replicas_(1 < num_nodes_ ? std::make_unique<Replica[]>(num_nodes_) : nullptr)
+    {
+    }
+
+    T const &local()
+    {
+        if constexpr (std::copy_constructible<T>)
+        {
+            if (1 < num_nodes_)
+            {
+                auto &replica = replicas_[current_numa_node()];
+                std::call_once(replica.once, [&]() { replica.value.emplace(original_); });
+                return *replica.value;
+            }
+        }
+        return original_;
+    }
+
+  private:
+    struct Replica
+    {
+        std::once_flag once;
+        std::optional<T> value;
+    };
+
+    T const &original_;
+    sz num_nodes_;
+    std::unique_ptr<Replica[]> replicas_;
+};
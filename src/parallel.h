@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+
+// 프로세스 전체가 함께 쓰는 work-stealing 스레드 풀
+// 작업자마다 덱을 두고, 작업자가 넣은 작업은 자기 덱의 뒤에서 꺼내며, 자기 덱이 비었다면 다른 덱의 앞에서 훔친다.
+// 작업자가 아닌 스레드(main)가 넣은 작업은 별도의 덱에 들어간다. 작업은 자신이 속한 묶음의 대기 작업 수를 가리키며,
+// 묶음을 기다리는 스레드는 잠들기 전에 그 묶음의 남은 작업만 대신 실행한다. 다른 묶음의 작업(예를 들어 다른 케이스
+// 전체)을 자기 스택 위에서 실행하면 그 작업이 끝날 때까지 자기 묶음을 이어갈 수 없기 때문이다. 기다리는 작업은 자신이
+// 나눈 작업만 기다리므로, 작업 안에서 다시 작업을 나누고 기다려도 교착되지 않는다.
+// 작업은 예외를 던지지 않아야 하며, 던진다면 std::terminate가 호출된다. TaskGroup은 예외를 잡아 wait()에서 다시 던진다.
+class ThreadPool
+{
+  public:
+    // 묶음마다 넣었지만 아직 꺼내지 않은 작업의 수
+    using GroupCounter = std::atomic<sz>;
+
+    explicit ThreadPool(sz const num_workers) : num_workers_(num_workers), queues_(num_workers + 1)
+    {
+        workers_.reserve(num_workers);
+        for (auto i = sz(); i < num_workers; ++i)
+        {
+            workers_.emplace_back([this, i]() {
+                worker_index() = i;
+                work();
+            });
+        }
+    }
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool &operator=(ThreadPool const &) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            auto const lock = std::lock_guard(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        std::ranges::for_each(workers_, &std::thread::join);
+    }
+
+    // 작업을 실행하는 스레드의 수. 기다리는 스레드도 작업을 실행하므로 작업자 수에 하나를 더한다.
+    sz num_threads() const noexcept
+    {
+        return num_workers_ + 1;
+    }
+
+    // group이 null이 아니라면 작업은 그 묶음에 속한다.
+    void submit(std::function<void()> fn, GroupCounter *const group = nullptr)
+    {
+        auto const idx = std::min(worker_index(), num_workers_);
+        if (group != nullptr)
+        {
+            group->fetch_add(1, std::memory_order_release);
+        }
+        num_queued_.fetch_add(1, std::memory_order_release);
+        {
+            auto const lock = std::lock_guard(queues_[idx].mutex);
+            queues_[idx].tasks.push_back(Task{std::move(fn), group});
+        }
+        {
+            auto const lock = std::lock_guard(mutex_);
+        }
+        // 묶음을 기다리는 스레드와 쉬는 작업자가 같은 조건 변수에서 잠들므로, 하나만 깨우면 이 작업을 실행할 수 없는
+        // 스레드가 깨어나고 실행할 수 있는 스레드는 계속 잠들 수 있다.
+        cv_.notify_all();
+    }
+
+    // done()이 참이 될 때까지 group에 속한 남은 작업을 대신 실행하고, 실행할 작업이 없다면 잠든다.
+    // done()을 참으로 만드는 쪽은 notify_waiters()를 호출해야 한다.
+    template <typename Done>
+    void help_until(GroupCounter &group, Done &&done)
+    {
+        while (!done())
+        {
+            if (run_one(&group))
+            {
+                continue;
+            }
+            auto lock = std::unique_lock(mutex_);
+            cv_.wait(lock, [&]() { return done() || 0 < group.load(std::memory_order_acquire); });
+        }
+    }
+
+    // 작업자 스레드마다 fn(std::thread &)를 호출한다. CPU 고정처럼 스레드 자체를 다룰 때 쓴다.
+    template <typename Fn>
+    void for_each_worker(Fn &&fn)
+    {
+        std::ranges::for_each(workers_, fn);
+    }
+
+    void notify_waiters()
+    {
+        {
+            auto const lock = std::lock_guard(mutex_);
+        }
+        cv_.notify_all();
+    }
+
+  private:
+    struct Task
+    {
+        std::function<void()> fn;
+        GroupCounter *group;
+    };
+
+    struct alignas(64) Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // 작업자가 아닌 스레드에서는 num_workers_ 이상의 값이다.
+    static sz &worker_index() noexcept
+    {
+        thread_local auto idx = static_cast<sz>(-1);
+        return idx;
+    }
+
+    // 남은 작업을 하나 실행했다면 true를 반환한다. group이 null이 아니라면 그 묶음의 작업만 실행한다.
+    bool run_one(GroupCounter const *const group)
+    {
+        auto task = take(group);
+        if (!task.fn)
+        {
+            return false;
+        }
+        run(task.fn);
+        return true;
+    }
+
+    static void run(std::function<void()> &fn) noexcept
+    {
+        fn();
+    }
+
+    // 자기 덱에서는 가장 최근에 넣은 작업을, 다른 덱에서는 가장 오래된 작업을 꺼낸다.
+    Task take(GroupCounter const *const group)
+    {
+        auto const matches = [group](Task const &task) { return group == nullptr || task.group == group; };
+        auto const self = std::min(worker_index(), num_workers_);
+        for (auto offset = sz(); offset < queues_.size(); ++offset)
+        {
+            auto &queue = queues_[(self + offset) % queues_.size()];
+            auto const lock = std::lock_guard(queue.mutex);
+            auto it = queue.tasks.end();
+            if (offset == 0)
+            {
+                auto const found = std::find_if(queue.tasks.rbegin(), queue.tasks.rend(), matches);
+                it = found == queue.tasks.rend() ? queue.tasks.end() : std::prev(found.base());
+            }
+            else
+            {
+                it = std::find_if(queue.tasks.begin(), queue.tasks.end(), matches);
+            }
+            if (it != queue.tasks.end())
+            {
+                auto task = std::move(*it);
+                queue.tasks.erase(it);
+                if (task.group != nullptr)
+                {
+                    task.group->fetch_sub(1, std::memory_order_relaxed);
+                }
+                num_queued_.fetch_sub(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+        return Task();
+    }
+
+    void work()
+    {
+        while (true)
+        {
+            if (run_one(nullptr))
+            {
+                continue;
+            }
+            auto lock = std::unique_lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || 0 < num_queued_.load(std::memory_order_acquire); });
+            if (stopping_)
+            {
+                return;
+            }
+        }
+    }
+
+    sz const num_workers_;
+    std::vector<Queue> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<sz> num_queued_ = 0;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+// 하드웨어 스레드 수만큼의 스레드로 작업을 실행하는 공용 풀. 처음 사용할 때 만들어진다.
+// 작업 안에서 std::exit가 호출되더라도 자기 자신을 join하지 않도록 풀은 소멸시키지 않는다.
+inline ThreadPool &thread_pool()
+{
+    static auto &pool = *new ThreadPool(std::max(static_cast<unsigned>(1), std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+// thread_pool()에 넣은 작업들이 모두 끝나기를 기다린다. 기다리는 동안 이 묶음의 남은 작업만 대신 실행한다.
+// 작업이 던진 예외는 잡아 두었다가 wait()에서 처음 것을 다시 던진다. 소멸자는 기다리기만 하고 던지지 않는다.
+class TaskGroup
+{
+  public:
+    TaskGroup() = default;
+    TaskGroup(TaskGroup const &) = delete;
+    TaskGroup &operator=(TaskGroup const &) = delete;
+
+    ~TaskGroup()
+    {
+        wait_for_tasks();
+    }
+
+    template <typename Fn>
+    void run(Fn &&fn)
+    {
+        num_pending_.fetch_add(1, std::memory_order_relaxed);
+        thread_pool().submit(
+            [this, fn = std::forward<Fn>(fn)]() mutable {
+                try
+                {
+                    fn();
+                }
+                catch (...)
+                {
+                    auto const lock = std::lock_guard(mutex_);
+                    if (!exception_)
+                    {
+                        exception_ = std::current_exception();
+                    }
+                }
+                if (num_pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    thread_pool().notify_waiters();
+                }
+            },
+            &num_queued_);
+    }
+
+    void wait()
+    {
+        wait_for_tasks();
+        auto const lock = std::lock_guard(mutex_);
+        if (exception_)
+        {
+            std::rethrow_exception(std::exchange(exception_, nullptr));
+        }
+    }
+
+  private:
+    void wait_for_tasks()
+    {
+        thread_pool().help_until(num_queued_,
+                                 [this]() { return num_pending_.load(std::memory_order_acquire) == 0; });
+    }
+
+    std::atomic<sz> num_pending_ = 0;
+    ThreadPool::GroupCounter num_queued_ = 0;
+    std::mutex mutex_;
+    std::exception_ptr exception_;
+};
+
+// 최대 num_threads개의 실행 단위가 [0, num_tasks) 범위의 작업을 하나씩 가져가 fn(task, thread_idx)를 호출한다.
+// thread_idx는 [0, num_threads) 범위이며, 같은 thread_idx로 동시에 호출되는 일은 없다.
+// 실행 단위는 thread_pool()의 작업이므로, 여러 곳에서 동시에 호출된 parallel_for들이 풀의 스레드를 나누어 쓴다.
+// 먼저 끝난 쪽의 스레드는 다른 쪽의 남은 실행 단위를 가져가므로, 전체 실행 시간은 전체 작업량을 스레드 수로 나눈 값에
+// 가까워진다. 호출한 스레드는 thread_idx 0을 직접 실행한다.
+template <typename Fn>
+void parallel_for(sz const num_threads, sz const num_tasks, Fn &&fn)
+{
+    auto next_task = std::atomic<sz>(0);
+    auto const work = [&](sz const thread_idx) {
+        for (auto task = next_task++; task < num_tasks; task = next_task++)
+        {
+            fn(task, thread_idx);
+        }
+    };
+
+    auto group = TaskGroup();
+    for (auto i = static_cast<sz>(1); i < std::min(num_threads, num_tasks); ++i)
+    {
+        group.run([&work, i]() { work(i); });
+    }
+    work(0);
+    group.wait();
+}
+
+struct alignas(64) PaddedCounter
+{
+    sz value = 0;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+#include "types.h"
+
+// 일괄 조회 API가 한 번에 해시를 계산하고 프리페치하는 키의 개수
+constexpr static auto PREFETCH_BATCH_SIZE = static_cast<sz>(64);
+
+// 읽기용 소프트웨어 프리페치. 지원하지 않는 컴파일러에서는 아무것도 하지 않는다.
+inline void prefetch_read(void const *const address) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address, 0, 3);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<char const *>(address), _MM_HINT_T0);
+#else
+    static_cast<void>(address);
+#endif
+}
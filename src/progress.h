@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "types.h"
+
+// 양측 95% 신뢰 구간의 정규 분위수
+constexpr static auto CONFIDENCE_Z = 1.959963984540054;
+
+struct ProportionInterval
+{
+    double lower;
+    double upper;
+};
+
+// num_trials번 중 num_successes번 일어난 사건의 확률에 대한 Wilson score 구간
+// 충돌처럼 확률이 아주 작아 정규 근사 구간이 0 아래로 내려가는 경우에도 [0, 1] 안에 머문다.
+inline ProportionInterval wilson_interval(sz const num_successes, sz const num_trials,
+                                          double const z = CONFIDENCE_Z) noexcept
+{
+    if (num_trials == 0)
+    {
+        return ProportionInterval{0.0, 1.0};
+    }
+    auto const n = static_cast<double>(num_trials);
+    auto const p = static_cast<double>(num_successes) / n;
+    auto const z2 = z * z;
+    auto const center = (p + z2 / (2 * n)) / (1 + z2 / n);
+    auto const half_width = z / (1 + z2 / n) * std::sqrt(p * (1 - p) / n + z2 / (4 * n * n));
+    return ProportionInterval{std::max(0.0, center - half_width), std::min(1.0, center + half_width)};
+}
+
+// 구간의 반폭이 추정치의 precision배 이하라면 true를 반환한다. 충돌이 없다면 추정치가 0이므로 수렴하지 않는다.
+inline bool has_converged(sz const num_successes, sz const num_trials, double const precision) noexcept
+{
+    if (num_successes == 0)
+    {
+        return false;
+    }
+    auto const interval = wilson_interval(num_successes, num_trials);
+    auto const p = static_cast<double>(num_successes) / static_cast<double>(num_trials);
+    return (interval.upper - interval.lower) / 2 <= precision * p;
+}
+
+// 케이스 하나의 진행 상황
+// 작업 스레드는 청크를 끝낼 때마다 relaxed로 더하고 ProgressReporter가 주기적으로 읽으므로, 서로 다른 값 사이의
+// 순서는 보장되지 않는다. 표시용으로만 쓴다.
+struct CaseProgress
+{
+    std::string_view name;
+    std::atomic<sz> num_nicknames = 0;
+    std::atomic<sz> num_generated = 0;
+    std::atomic<sz> num_planned_tries = 0;
+    std::atomic<sz> num_tries = 0;
+    std::atomic<sz> num_collisions = 0;
+
+    // 목표 크기가 target인 채우기 단계를 시작한다. 이전 지점의 검사 결과는 지운다.
+    void begin_fill(sz const target) noexcept
+    {
+        num_nicknames.store(target, std::memory_order_relaxed);
+        num_generated.store(0, std::memory_order_relaxed);
+        begin_probe(0);
+    }
+
+    // planned번 검사하는 단계를 시작한다.
+    void begin_probe(sz const planned) noexcept
+    {
+        num_planned_tries.store(planned, std::memory_order_relaxed);
+        num_tries.store(0, std::memory_order_relaxed);
+        num_collisions.store(0, std::memory_order_relaxed);
+    }
+
+    void add_generated(sz const count) noexcept
+    {
+        num_generated.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void add_tries(sz const count, sz const collisions) noexcept
+    {
+        num_tries.fetch_add(count, std::memory_order_relaxed);
+        num_collisions.fetch_add(collisions, std::memory_order_relaxed);
+    }
+};
+
+// interval마다 각 케이스의 진행 상황을 로그로 남기는 스레드. interval이 0이라면 아무것도 하지 않는다.
+// 직전 보고 이후 생성하거나 검사한 닉네임이 없는 케이스(시작 전이거나 끝난 케이스)는 건너뛰며,
+// 처리 속도는 직전 보고 이후의 그 수로 계산한다.
+class ProgressReporter
+{
+  public:
+    ProgressReporter(std::span<CaseProgress const> const cases, std::chrono::duration<double> const interval)
+        : cases_(cases), last_counts_(cases.size())
+    {
+        if (0 < interval.count())
+        {
+            thread_ = std::thread([this, interval]() { run(interval); });
+        }
+    }
+
+    ProgressReporter(ProgressReporter const &) = delete;
+    ProgressReporter &operator=(ProgressReporter const &) = delete;
+
+    ~ProgressReporter()
+    {
+        {
+            auto const lock = std::lock_guard(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+  private:
+    void run(std::chrono::duration<double> const interval)
+    {
+        auto last = std::chrono::steady_clock::now();
+        auto lock = std::unique_lock(mutex_);
+        while (!cv_.wait_for(lock, interval, [this]() { return stopping_; }))
+        {
+            auto const now = std::chrono::steady_clock::now();
+            auto const seconds = std::chrono::duration<double>(now - last).count();
+            last = now;
+            for (auto i = sz(); i < cases_.size(); ++i)
+            {
+                report(cases_[i], last_counts_[i], seconds);
+            }
+        }
+    }
+
+    static void report(CaseProgress const &progress, sz &last_count, double const seconds)
+    {
+        auto const num_generated = progress.num_generated.load(std::memory_order_relaxed);
+        auto const num_tries = progress.num_tries.load(std::memory_order_relaxed);
+        auto const num_collisions = progress.num_collisions.load(std::memory_order_relaxed);
+        auto const count = num_generated + num_tries;
+        if (count == last_count)
+        {
+            return;
+        }
+        auto const per_second = 0 < seconds ? static_cast<double>(count - std::min(last_count, count)) / seconds : 0.0;
+        last_count = count;
+        if (num_tries == 0)
+        {
+            spdlog::info("[{}] 진행: 생성 {}/{}, {:.0f}/s", progress.name, num_generated,
+                         progress.num_nicknames.load(std::memory_order_relaxed), per_second);
+            return;
+        }
+        auto const interval = wilson_interval(num_collisions, num_tries);
+        spdlog::info("[{}] 진행: 생성 {}/{}, 검사 {}/{}, 충돌 확률 = {:.4g}% (95% 신뢰 구간 {:.4g}% ~ {:.4g}%), {:.0f}/s",
+                     progress.name, num_generated, progress.num_nicknames.load(std::memory_order_relaxed), num_tries,
+                     progress.num_planned_tries.load(std::memory_order_relaxed),
+                     static_cast<double>(num_collisions) / static_cast<double>(num_tries) * 100,
+                     interval.lower * 100, interval.upper * 100, per_second);
+    }
+
+    std::span<CaseProgress const> cases_;
+    std::vector<sz> last_counts_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
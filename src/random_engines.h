@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#include "types.h"
+
+#if defined(__SIZEOF_INT128__)
+// -Wpedantic에서도 경고가 나지 않도록 확장 타입임을 밝힌다.
+__extension__ typedef unsigned __int128 u128;
+#endif
+
+// 64비트 정수 두 개의 곱을 (하위 64비트, 상위 64비트)로 반환한다.
+constexpr std::pair<u64, u64> mul_64x64_128(u64 const a, u64 const b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    auto const product = static_cast<u128>(a) * b;
+    return {static_cast<u64>(product), static_cast<u64>(product >> 64)};
+#else
+#if defined(_MSC_VER) && defined(_M_X64)
+    if (!std::is_constant_evaluated())
+    {
+        auto hi = u64();
+        auto const lo = _umul128(a, b, &hi);
+        return {lo, hi};
+    }
+#endif
+    auto const a_lo = a & 0xffffffffULL;
+    auto const a_hi = a >> 32;
+    auto const b_lo = b & 0xffffffffULL;
+    auto const b_hi = b >> 32;
+    auto const lo_lo = a_lo * b_lo;
+    auto const hi_lo = a_hi * b_lo;
+    auto const cross = (lo_lo >> 32) + (hi_lo & 0xffffffffULL) + a_lo * b_hi;
+    return {(cross << 32) | (lo_lo & 0xffffffffULL), (hi_lo >> 32) + (cross >> 32) + a_hi * b_hi};
+#endif
+}
+
+// http://prng.di.unimi.it/splitmix64.c
+class SplitMix64
+{
+  public:
+    using result_type = u64;
+
+    constexpr explicit SplitMix64(u64 const seed = 0) noexcept : state_(seed)
+    {
+    }
+
+    constexpr static result_type min() noexcept
+    {
+        return std::numeric_limits<result_type>::min();
+    }
+
+    constexpr static result_type max() noexcept
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    constexpr result_type operator()() noexcept
+    {
+        return mix(state_ += 0x9e3779b97f4a7c15ULL);
+    }
+
+    constexpr static u64 mix(u64 z) noexcept
+    {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+  private:
+    u64 state_;
+};
+
+// http://prng.di.unimi.it/xoshiro256starstar.c
+class Xoshiro256StarStar
+{
+  public:
+    using result_type = u64;
+
+    constexpr explicit Xoshiro256StarStar(u64 const seed = 0) noexcept
+    {
+        auto seeder = SplitMix64(seed);
+        for (auto &word : state_)
+        {
+            word = seeder();
+        }
+    }
+
+    // 상태를 그대로 지정한다. 참조 구현의 출력과 비교할 때 쓴다. 상태가 모두 0이어서는 안 된다.
+    constexpr explicit Xoshiro256StarStar(std::array<u64, 4> const &state) noexcept : state_(state)
+    {
+    }
+
+    constexpr static result_type min() noexcept
+    {
+        return std::numeric_limits<result_type>::min();
+    }
+
+    constexpr static result_type max() noexcept
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    constexpr result_type operator()() noexcept
+    {
+        auto const result = std::rotl(state_[1] * 5, 7) * 9;
+        auto const t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = std::rotl(state_[3], 45);
+        return result;
+    }
+
+  private:
+    std::array<u64, 4> state_{};
+};
+
+// PCG XSL RR 128/64 (https://www.pcg-random.org), numpy의 PCG64와 같은 출력 함수를 사용한다.
+class Pcg64
+{
+  public:
+    using result_type = u64;
+
+    constexpr explicit Pcg64(u64 const seed = 0) noexcept
+    {
+        auto seeder = SplitMix64(seed);
+        inc_lo_ = seeder() | 1;
+        inc_hi_ = seeder();
+        seed_state(seeder(), seeder());
+    }
+
+    // 참조 구현의 pcg64(initstate, initseq)와 같은 상태에서 시작한다. 128비트 값은 (하위, 상위) 64비트로 받는다.
+    constexpr Pcg64(u64 const initstate_lo, u64 const initstate_hi, u64 const initseq_lo, u64 const initseq_hi) noexcept
+        : inc_lo_(initseq_lo << 1 | 1), inc_hi_(initseq_hi << 1 | initseq_lo >> 63)
+    {
+        seed_state(initstate_lo, initstate_hi);
+    }
+
+    constexpr static result_type min() noexcept
+    {
+        return std::numeric_limits<result_type>::min();
+    }
+
+    constexpr static result_type max() noexcept
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    constexpr result_type operator()() noexcept
+    {
+        step();
+        return std::rotr(state_hi_ ^ state_lo_, static_cast<int>(state_hi_ >> 58));
+    }
+
+  private:
+    constexpr static auto MULTIPLIER_LO = 0x4385df649fccf645ULL;
+    constexpr static auto MULTIPLIER_HI = 0x2360ed051fc65da4ULL;
+
+    constexpr void seed_state(u64 const lo, u64 const hi) noexcept
+    {
+        step();
+        add(lo, hi);
+        step();
+    }
+
+    constexpr void add(u64 const lo, u64 const hi) noexcept
+    {
+        state_lo_ += lo;
+        state_hi_ += hi + (state_lo_ < lo ? 1 : 0);
+    }
+
+    constexpr void step() noexcept
+    {
+        auto const [lo, hi] = mul_64x64_128(state_lo_, MULTIPLIER_LO);
+        state_hi_ = hi + state_lo_ * MULTIPLIER_HI + state_hi_ * MULTIPLIER_LO;
+        state_lo_ = lo;
+        add(inc_lo_, inc_hi_);
+    }
+
+    u64 state_lo_ = 0;
+    u64 state_hi_ = 0;
+    u64 inc_lo_ = 0;
+    u64 inc_hi_ = 0;
+};
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3")
+// 64비트 시드를 키로, 블록 번호를 카운터로 사용하는 카운터 기반 엔진이며 블록 하나로 64비트 출력 두 개를 만든다.
+class Philox4x32
+{
+  public:
+    using result_type = u64;
+
+    constexpr explicit Philox4x32(u64 const seed = 0) noexcept
+        : key_{static_cast<u32>(seed), static_cast<u32>(seed >> 32)}
+    {
+    }
+
+    constexpr static result_type min() noexcept
+    {
+        return std::numeric_limits<result_type>::min();
+    }
+
+    constexpr static result_type max() noexcept
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    constexpr result_type operator()() noexcept
+    {
+        if (num_buffered_ == 0)
+        {
+            generate_block();
+            num_buffered_ = buffer_.size();
+        }
+        return buffer_[buffer_.size() - num_buffered_--];
+    }
+
+    // 다음 출력이 block번째 블록에서 시작하도록 카운터를 옮긴다.
+    constexpr void seek(u64 const block) noexcept
+    {
+        counter_ = block;
+        num_buffered_ = 0;
+    }
+
+  private:
+    constexpr void generate_block() noexcept
+    {
+        constexpr auto M0 = 0xd2511f53ULL;
+        constexpr auto M1 = 0xcd9e8d57ULL;
+        constexpr auto W0 = 0x9e3779b9U;
+        constexpr auto W1 = 0xbb67ae85U;
+
+        auto c = std::array<u32, 4>{static_cast<u32>(counter_), static_cast<u32>(counter_ >> 32), 0, 0};
+        auto k = key_;
+        for (auto round = 0; round < 10; ++round)
+        {
+            auto const p0 = M0 * c[0];
+            auto const p1 = M1 * c[2];
+            c = {static_cast<u32>(p1 >> 32) ^ c[1] ^ k[0], static_cast<u32>(p1),
+                 static_cast<u32>(p0 >> 32) ^ c[3] ^ k[1], static_cast<u32>(p0)};
+            k[0] += W0;
+            k[1] += W1;
+        }
+        ++counter_;
+        buffer_[0] = (static_cast<u64>(c[1]) << 32) | c[0];
+        buffer_[1] = (static_cast<u64>(c[3]) << 32) | c[2];
+    }
+
+    std::array<u32, 2> key_;
+    u64 counter_ = 0;
+    std::array<u64, 2> buffer_{};
+    sz num_buffered_ = 0;
+};
+
+// std::mersenne_twister_engine과 같은 출력열을 만들지만, 시드 초기화와 twist를 출력이 필요한 만큼만 수행한다.
+// i번째 출력은 이전 상태의 i, i + 1, i + m번째 값에만 의존하므로, 엔진을 만들자마자 몇 개의 값만 뽑고 버리는 경우
+// 상태 전체(mt19937은 624개)를 초기화하고 twist하는 비용의 대부분을 생략할 수 있다.
+template <typename UIntType, sz w, sz n, sz m, sz r, UIntType a, sz u, UIntType d, sz s, UIntType b, sz t,
+          UIntType c, sz l, UIntType f>
+class LazyMersenneTwister
+{
+  public:
+    using result_type = UIntType;
+
+    constexpr explicit LazyMersenneTwister(result_type const seed = 5489u) noexcept
+    {
+        state_[0] = seed & MASK;
+    }
+
+    constexpr static result_type min() noexcept
+    {
+        return 0;
+    }
+
+    constexpr static result_type max() noexcept
+    {
+        return MASK;
+    }
+
+    constexpr result_type operator()() noexcept
+    {
+        if (num_seeded_ < n)
+        {
+            seed_until(std::min(n, idx_ + m + 1));
+        }
+        auto const next = idx_ + 1 == n ? 0 : idx_ + 1;
+        auto const y = (state_[idx_] & UPPER_MASK) | (state_[next] & LOWER_MASK);
+        state_[idx_] = state_[(idx_ + m) % n] ^ (y >> 1) ^ ((y & 1) != 0 ? a : 0);
+
+        auto z = state_[idx_];
+        idx_ = next;
+        z ^= (z >> u) & d;
+        z ^= (z << s) & b;
+        z ^= (z << t) & c;
+        z ^= z >> l;
+        return z & MASK;
+    }
+
+  private:
+    constexpr static auto MASK = w == std::numeric_limits<UIntType>::digits ? ~UIntType() : (UIntType(1) << w) - 1;
+    constexpr static auto LOWER_MASK = (UIntType(1) << r) - 1;
+    constexpr static auto UPPER_MASK = ~LOWER_MASK & MASK;
+
+    constexpr void seed_until(sz const count) noexcept
+    {
+        for (; num_seeded_ < count; ++num_seeded_)
+        {
+            auto const prev = state_[num_seeded_ - 1];
+            state_[num_seeded_] = (f * (prev ^ (prev >> (w - 2))) + static_cast<UIntType>(num_seeded_)) & MASK;
+        }
+    }
+
+    std::array<UIntType, n> state_{};
+    sz num_seeded_ = 1;
+    sz idx_ = 0;
+};
+
+using LazyMt19937 = LazyMersenneTwister<u32, 32, 624, 397, 31, 0x9908b0dfU, 11, 0xffffffffU, 7, 0x9d2c5680U, 15,
+                                        0xefc60000U, 18, 1812433253U>;
+using LazyMt19937_64 =
+    LazyMersenneTwister<u64, 64, 312, 156, 31, 0xb5026f5aa96619e9ULL, 29, 0x5555555555555555ULL, 17,
+                        0x71d67fffeda60000ULL, 37, 0xfff7eee000000000ULL, 43, 6364136223846793005ULL>;
+
+// 두 값을 섞어 서로 독립적인 스트림의 시드를 만든다.
+constexpr u64 derive_seed(u64 const seed, u64 const stream) noexcept
+{
+    return SplitMix64::mix(seed ^ SplitMix64::mix(stream + 0x9e3779b97f4a7c15ULL));
+}
+
+inline u64 random_device_seed()
+{
+    auto random_device = std::random_device();
+    return (static_cast<u64>(random_device()) << 32) | random_device();
+}
+
+// 케이스 이름 등으로 구분되는 스트림의 번호(FNV-1a 해시)
+constexpr u64 stream_id(std::string_view const name) noexcept
+{
+    auto hash = 0xcbf29ce484222325ULL;
+    for (auto const ch : name)
+    {
+        hash = (hash ^ static_cast<u8>(ch)) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// 64비트 시드로부터 엔진의 전체 상태를 초기화한다. 표준 엔진은 std::seed_seq를 통해 상태 전체에 시드를 퍼뜨린다.
+template <typename RandomEngine>
+RandomEngine make_random_engine(u64 const seed)
+{
+    if constexpr (std::is_constructible_v<RandomEngine, std::seed_seq &>)
+    {
+        auto words = SplitMix64(seed);
+        auto seq = std::seed_seq{static_cast<u32>(words()), static_cast<u32>(words()), static_cast<u32>(words()),
+                                 static_cast<u32>(words())};
+        return RandomEngine(seq);
+    }
+    else
+    {
+        return RandomEngine(seed);
+    }
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "nickname_key.h"
+#include "types.h"
+
+// 큰 영역을 운영체제에서 직접 받아 오는 memory_resource
+// Linux에서는 영역을 2 MiB 경계에 맞춰 매핑하고 투명 huge page를 요청해, 노드가 흩어진 집합의 TLB 미스를 줄인다.
+// 다른 플랫폼에서는 일반 페이지를 사용한다.
+class HugePageResource : public std::pmr::memory_resource
+{
+  public:
+    constexpr static auto HUGE_PAGE_SIZE = static_cast<sz>(2) << 20;
+
+    // 지금까지 매핑한 바이트 수
+    sz mapped_bytes() const noexcept
+    {
+        return mapped_bytes_;
+    }
+
+  private:
+    static sz round_up(sz const bytes) noexcept
+    {
+        return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+
+    void *do_allocate(sz const bytes, sz const alignment) override
+    {
+        if (HUGE_PAGE_SIZE < alignment)
+        {
+            throw std::bad_alloc();
+        }
+        auto const size = round_up(bytes);
+#if defined(_WIN32)
+        auto *const data = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+        if (data == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+#else
+        // 앞뒤로 남는 부분을 잘라 내 2 MiB 경계에 맞춘다.
+        auto *const mapped = static_cast<char *>(
+            mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (mapped == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        auto const misalignment = reinterpret_cast<std::uintptr_t>(mapped) % HUGE_PAGE_SIZE;
+        auto const head = misalignment == 0 ? sz() : HUGE_PAGE_SIZE - misalignment;
+        if (0 < head)
+        {
+            munmap(mapped, head);
+        }
+        munmap(mapped + head + size, HUGE_PAGE_SIZE - head);
+        auto *const data = mapped + head;
+#if defined(MADV_HUGEPAGE)
+        madvise(data, size, MADV_HUGEPAGE);
+#endif
+#endif
+        mapped_bytes_ += size;
+        return data;
+    }
+
+    void do_deallocate(void *const data, sz const bytes, sz) noexcept override
+    {
+#if defined(_WIN32)
+        VirtualFree(data, 0, MEM_RELEASE);
+#else
+        munmap(data, round_up(bytes));
+#endif
+        mapped_bytes_ -= round_up(bytes);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    sz mapped_bytes_ = 0;
+};
+
+// 닉네임을 문자열로 저장하는 std::unordered_set 기반의 참조 구현
+// 노드와 버킷은 모두 HugePageResource 위의 monotonic_buffer_resource에서 할당되므로, 원소마다 malloc을 호출하지 않는다.
+// 집합 자체도 그 위에 만들고 소멸자를 호출하지 않은 채 영역을 통째로 반납해, 노드를 하나씩 해제하지 않는다.
+// 노드가 가진 문자열은 SSO에 들어가거나 같은 영역에 있으므로 소멸자를 건너뛰어도 새는 메모리가 없다.
+// insert는 뮤텍스로 직렬화되며, insert가 끝난 뒤의 contains는 여러 스레드에서 동시에 호출할 수 있다.
+class ReferenceNicknameSet
+{
+  public:
+    using Set = std::pmr::unordered_set<std::pmr::string>;
+
+    // 노드 하나의 크기를 넉넉히 잡아 첫 버퍼 하나에 집합 전체가 들어가게 한다.
+    constexpr static auto BYTES_PER_NICKNAME = static_cast<sz>(64);
+
+    explicit ReferenceNicknameSet(sz const expected_size)
+        : arena_(std::max(expected_size, static_cast<sz>(1)) * BYTES_PER_NICKNAME, &upstream_),
+          set_(std::pmr::polymorphic_allocator<>(&arena_).new_object<Set>())
+    {
+        set_->reserve(expected_size);
+    }
+
+    ReferenceNicknameSet(ReferenceNicknameSet const &) = delete;
+    ReferenceNicknameSet &operator=(ReferenceNicknameSet const &) = delete;
+
+    ~ReferenceNicknameSet()
+    {
+        arena_.release();
+    }
+
+    bool insert(NicknameKey const key)
+    {
+        auto nickname = std::array<char, MAX_PACKED_NICKNAME_LEN>();
+        auto const len = unpack_nickname(key, nickname.data());
+        auto const lock = std::lock_guard(mutex_);
+        return set_->emplace(nickname.data(), len).second;
+    }
+
+    bool contains(NicknameKey const key) const
+    {
+        auto nickname = std::array<char, MAX_PACKED_NICKNAME_LEN>();
+        auto const len = unpack_nickname(key, nickname.data());
+        return set_->contains(std::pmr::string(nickname.data(), len));
+    }
+
+    void contains_batch(std::span<NicknameKey const> const keys, bool *const found) const
+    {
+        std::ranges::transform(keys, found, [this](NicknameKey const key) { return contains(key); });
+    }
+
+    sz size() const noexcept
+    {
+        return set_->size();
+    }
+
+    double load_factor() const noexcept
+    {
+        return static_cast<double>(set_->load_factor());
+    }
+
+    sz memory_usage() const noexcept
+    {
+        return upstream_.mapped_bytes();
+    }
+
+  private:
+    HugePageResource upstream_;
+    std::pmr::monotonic_buffer_resource arena_;
+    Set *set_;
+    std::mutex mutex_;
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <iterator>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <spdlog/spdlog.h>
+
+#include "bounded_random.h"
+#include "composition_plan.h"
+#include "nickname_key.h"
+#include "sample_nickname_opt.h"
+#include "types.h"
+#include "word_db.h"
+
+using NicknameBuffer = std::array<char, MAX_NICKNAME_LEN>;
+
+// 닉네임에 사용되는 문자는 RandomDigits<62>에 모아 둔 난수에서 뽑아, 문자마다 엔진을 호출하거나 나눗셈을 하지 않는다.
+using SymbolDigits = RandomDigits<NICKNAME_SYMBOLS.length()>;
+
+template <typename RandomEngine>
+char sample_ascii(RandomEngine &random_engine)
+{
+    return NICKNAME_SYMBOLS[bounded_random(random_engine, NICKNAME_SYMBOLS.length())];
+}
+
+template <typename RandomEngine>
+char sample_ascii(RandomEngine &random_engine, SymbolDigits &symbols)
+{
+    return NICKNAME_SYMBOLS[symbols.next(random_engine)];
+}
+
+template <typename RandomEngine>
+char sample_digit(RandomEngine &random_engine)
+{
+    return static_cast<char>('0' + bounded_random(random_engine, '9' - '0' + 1));
+}
+
+template <typename RandomEngine>
+char sample_ascii_lower(RandomEngine &random_engine)
+{
+    return static_cast<char>('a' + bounded_random(random_engine, 'z' - 'a' + 1));
+}
+
+// 숫자를 제외한 52개의 알파벳 중 하나를 균등하게 뽑으면 그 소문자 역시 균등하게 분포한다.
+template <typename RandomEngine>
+char sample_ascii_lower(RandomEngine &random_engine, SymbolDigits &symbols)
+{
+    constexpr auto NUM_DIGITS = static_cast<u64>('9' - '0' + 1);
+    auto symbol = symbols.next(random_engine);
+    while (symbol < NUM_DIGITS)
+    {
+        symbol = symbols.next(random_engine);
+    }
+    return static_cast<char>(std::tolower(NICKNAME_SYMBOLS[symbol]));
+}
+
+// std::tolower(sample_ascii(random_engine))와 같은 분포를 가진다.
+template <typename RandomEngine>
+char sample_ascii_folded(RandomEngine &random_engine, SymbolDigits &symbols)
+{
+    constexpr static auto FOLDED_SYMBOLS = []() {
+        auto symbols = std::array<char, NICKNAME_SYMBOLS.length()>();
+        std::ranges::transform(NICKNAME_SYMBOLS, std::ranges::begin(symbols),
+                               [](char const ch) { return 'A' <= ch && ch <= 'Z' ? ch - 'A' + 'a' : ch; });
+        return symbols;
+    }();
+    return FOLDED_SYMBOLS[symbols.next(random_engine)];
+}
+
+template <typename RandomEngine>
+std::string_view sample_word(RandomEngine &random_engine, WordDB const &word_db, sz const min_len, sz const max_len)
+{
+    auto const first = word_db.first_index[min_len];
+    auto const last = word_db.first_index[max_len + 1];
+    if (first == last)
+    {
+        constexpr auto msg = "there are no words to sample";
+        spdlog::critical(msg);
+        throw std::runtime_error(msg);
+    }
+
+    return word_db.word(first + bounded_random(random_engine, last - first));
+}
+
+// out의 앞 len개 문자 중 num_mangled개를 부분 Fisher-Yates로 균등하게 골라 변형한다.
+template <typename RandomEngine>
+void mangle_word(RandomEngine &random_engine, SymbolDigits &symbols, sz const len, sz const num_mangled,
+                 char *const out)
+{
+    auto indices = std::array<u8, MAX_NICKNAME_LEN>();
+    auto num_indices = len;
+    std::iota(std::ranges::begin(indices), std::ranges::next(std::ranges::begin(indices), num_indices), u8());
+    for (auto i = sz(); i < num_mangled; ++i)
+    {
+        auto idx = static_cast<sz>(bounded_random(random_engine, num_indices));
+        std::swap(indices[idx], indices[num_indices - 1]);
+        idx = indices[--num_indices];
+        if (idx == 0)
+        {
+            out[idx] = sample_ascii_lower(random_engine, symbols);
+        }
+        else
+        {
+            out[idx] = sample_ascii_folded(random_engine, symbols);
+        }
+    }
+}
+
+template <typename RandomEngine>
+sz sample_and_mangle_word(RandomEngine &random_engine, SymbolDigits &symbols, WordDB const &word_db, sz const min_len,
+                          sz const max_len, double const mangling_factor, char *const out)
+{
+    auto const word = sample_word(random_engine, word_db, min_len, max_len);
+    std::ranges::copy(word, out);
+    mangle_word(random_engine, symbols, word.length(), num_mangled_chars(word.length(), mangling_factor), out);
+    return word.length();
+}
+
+// 조각들을 먼저 pieces_buffer에 순서대로 생성한 뒤, 섞인 순서대로 out에 이어 붙인다.
+// 닉네임과 조각의 수는 모두 MAX_NICKNAME_LEN 이하이므로 힙 할당이 발생하지 않는다.
+template <typename RandomEngine>
+sz sample_nickname(RandomEngine &random_engine, WordDB const &word_db, SampleNicknameOpt const &opt,
+                   NicknameBuffer &out)
+{
+    auto symbols = SymbolDigits();
+    auto pieces_buffer = NicknameBuffer();
+    auto pieces = std::array<std::string_view, MAX_NICKNAME_LEN>();
+    auto num_pieces = sz();
+    auto length = sz();
+    auto chance = opt.min_len + static_cast<sz>(bounded_random(random_engine, opt.max_len - opt.min_len + 1));
+    while (0 < chance)
+    {
+        auto *const piece = pieces_buffer.data() + length;
+        auto piece_len = sz();
+        if (chance < opt.min_word_len)
+        {
+            piece[piece_len++] = sample_ascii_lower(random_engine, symbols);
+            while (piece_len < chance)
+            {
+                piece[piece_len++] = sample_ascii(random_engine, symbols);
+            }
+        }
+        else
+        {
+            piece_len = sample_and_mangle_word(random_engine, symbols, word_db, opt.min_word_len,
+                                               std::min(opt.max_word_len, chance), opt.mangling_factor, piece);
+            piece[0] = static_cast<char>(std::toupper(piece[0]));
+        }
+        chance -= piece_len;
+        length += piece_len;
+        pieces[num_pieces++] = std::string_view(piece, piece_len);
+    }
+
+    shuffle(random_engine, std::span(pieces.data(), num_pieces));
+    auto it = std::ranges::begin(out);
+    for (auto const piece : std::span(pieces.data(), num_pieces))
+    {
+        it = std::ranges::copy(piece, it).out;
+    }
+    return length;
+}
+
+template <typename RandomEngine>
+std::string sample_nickname(RandomEngine &random_engine, WordDB const &word_db, SampleNicknameOpt const &opt)
+{
+    auto nickname = NicknameBuffer();
+    auto const length = sample_nickname(random_engine, word_db, opt, nickname);
+    return std::string(nickname.data(), length);
+}
+
+template <typename RandomEngine>
+NicknameKey sample_nickname_key(RandomEngine &random_engine, WordDB const &word_db, SampleNicknameOpt const &opt)
+{
+    auto nickname = NicknameBuffer();
+    auto const length = sample_nickname(random_engine, word_db, opt, nickname);
+    return pack_nickname(std::string_view(nickname.data(), length));
+}
+
+// 구성 계획을 하나 뽑은 뒤 계획의 길이마다 단어를 뽑는다. 분포는 sample_nickname과 같지만 난수 스트림은 다르다.
+// 조각의 내용은 순서와 독립이므로 조각의 순서를 먼저 섞고 out에 바로 생성해, 조각을 따로 모았다가 복사하지 않는다.
+template <typename RandomEngine>
+sz sample_nickname(RandomEngine &random_engine, CompositionPlans const &plans, NicknameBuffer &out)
+{
+    auto const &plan = plans.sample(random_engine);
+    auto const num_pieces = static_cast<sz>(plan.num_words) + (0 < plan.filler_len ? 1 : 0);
+    auto order = std::array<u8, MAX_PACKED_NICKNAME_LEN + 1>();
+    std::iota(std::ranges::begin(order), std::ranges::next(std::ranges::begin(order), num_pieces), u8());
+    shuffle(random_engine, std::span(order.data(), num_pieces));
+
+    auto symbols = SymbolDigits();
+    auto *piece = out.data();
+    for (auto const idx : std::span(order.data(), num_pieces))
+    {
+        if (idx == plan.num_words)
+        {
+            piece[0] = sample_ascii_lower(random_engine, symbols);
+            for (auto pos = static_cast<sz>(1); pos < plan.filler_len; ++pos)
+            {
+                piece[pos] = sample_ascii(random_engine, symbols);
+            }
+            piece += plan.filler_len;
+            continue;
+        }
+        auto const len = static_cast<sz>(plan.word_lens[idx]);
+        auto const &bucket = plans.word_bucket(len);
+        std::ranges::copy_n(bucket.chars + bounded_random(random_engine, bucket.num_words) * len, len, piece);
+        mangle_word(random_engine, symbols, len, plans.mangled_chars(len), piece);
+        // 단어는 ASCII 심볼로만 이루어지므로 로케일을 거치는 std::toupper 대신 직접 바꾼다.
+        piece[0] = 'a' <= piece[0] && piece[0] <= 'z' ? static_cast<char>(piece[0] - 'a' + 'A') : piece[0];
+        piece += len;
+    }
+    return static_cast<sz>(piece - out.data());
+}
+
+template <typename RandomEngine>
+NicknameKey sample_nickname_key(RandomEngine &random_engine, CompositionPlans const &plans)
+{
+    auto nickname = NicknameBuffer();
+    auto const length = sample_nickname(random_engine, plans, nickname);
+    return pack_nickname(std::string_view(nickname.data(), length));
+}
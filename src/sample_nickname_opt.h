@@ -0,0 +1,37 @@
+#pragma once
+
+#include <algorithm>
+
+#include "nickname_key.h"
+#include "types.h"
+
+struct SampleNicknameOpt
+{
+    sz min_len;
+    sz max_len;
+    sz min_word_len;
+    sz max_word_len;
+    double mangling_factor;
+
+    bool operator==(SampleNicknameOpt const &) const = default;
+};
+
+constexpr static auto SAMPLE_NICKNAME_OPT = SampleNicknameOpt{8, 8, 3, 8, 2.7};
+static_assert(SAMPLE_NICKNAME_OPT.max_len <= MAX_PACKED_NICKNAME_LEN);
+
+// 길이가 len인 단어에서 변형되는 문자의 수 round(len / mangling_factor)를 len 이하로 제한한 값
+// std::round는 constexpr가 아니므로 직접 반올림한다. 결과는 양수에 대한 std::round와 같다.
+constexpr sz num_mangled_chars(sz const len, double const mangling_factor) noexcept
+{
+    auto const ratio = static_cast<double>(len) / mangling_factor;
+    if (!(0 < ratio))
+    {
+        return 0;
+    }
+    if (static_cast<double>(len) <= ratio)
+    {
+        return len;
+    }
+    auto const whole = static_cast<sz>(ratio);
+    return std::min(len, whole + (0.5 <= ratio - static_cast<double>(whole) ? 1 : 0));
+}
@@ -0,0 +1,321 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "key_partitions.h"
+#include "mapped_file.h"
+#include "nickname_key.h"
+#include "sample_nickname_opt.h"
+#include "types.h"
+
+// 여러 기계에 나누어 실행한 정렬 모드의 한 샤드가 남기는 부분 결과
+// 샤드는 청크 번호를 num_shards로 나눈 나머지가 shard_index인 청크만 생성하므로, 같은 시드로 실행한 샤드 전체의
+// 합집합은 한 기계에서의 정렬 모드와 같은 닉네임들이다. 파일에는 KeyPartitions의 파티션마다 정렬한 사전 생성 키의
+// 고유한 값들과 검사 키 전체가 들어가며, 키는 앞의 키와의 차이를 LEB128 가변 길이 정수로 기록한다.
+// 문자열은 기록하지 않으므로 파일은 키 하나에 평균 5바이트 남짓이다. 값은 기계의 바이트 순서로 기록한다.
+struct ShardRunsHeader
+{
+    std::array<char, 8> magic;
+    u32 version;
+    u32 num_partitions;
+    u64 shard_index;
+    u64 num_shards;
+    u64 seed;
+    u64 stream;
+    SampleNicknameOpt nickname_opt;
+    u64 num_initial_nicknames;
+    u64 num_tries;
+    // 샤드를 생성한 단어 목록. 다른 단어 목록으로 생성한 샤드는 합칠 수 없다.
+    u64 num_words;
+    u64 word_db_fingerprint;
+    // 이 샤드가 생성한 키의 수. 사전 생성 키는 중복을 포함한다.
+    u64 num_population_keys;
+    u64 num_probe_keys;
+};
+
+// 헤더 뒤에 파티션마다 하나씩 이어지는 목차
+struct ShardRunsPartition
+{
+    u64 offset;
+    u64 num_population_keys;
+    u64 population_bytes;
+    u64 num_probe_keys;
+    u64 probe_bytes;
+};
+
+constexpr static auto SHARD_RUNS_MAGIC = std::array{'N', 'I', 'C', 'K', 'R', 'U', 'N', 'S'};
+constexpr static auto SHARD_RUNS_VERSION = static_cast<u32>(2);
+
+// 닉네임 옵션을 구별하기 위한 FNV-1a 해시
+inline u64 sample_nickname_opt_hash(SampleNicknameOpt const &opt) noexcept
+{
+    auto hash = static_cast<u64>(0xcbf29ce484222325);
+    for (auto const value : {static_cast<u64>(opt.min_len), static_cast<u64>(opt.max_len),
+                             static_cast<u64>(opt.min_word_len), static_cast<u64>(opt.max_word_len),
+                             std::bit_cast<u64>(opt.mangling_factor)})
+    {
+        hash ^= value;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+// 같은 실험의 샤드 파일들을 한 디렉터리에 모을 수 있도록, 이름에 케이스의 스트림과 시드, 크기, 닉네임 옵션의 해시,
+// 샤드 번호를 넣는다. 실험이 다른 샤드는 이름이 다르므로 서로의 파일을 덮어쓰지 않는다.
+inline std::filesystem::path shard_runs_path(std::filesystem::path const &dir, ShardRunsHeader const &header)
+{
+    auto name = std::ostringstream();
+    name << std::hex << header.stream << std::dec << ".S" << header.seed << ".M"
+         << header.nickname_opt.mangling_factor << ".N" << header.num_initial_nicknames << ".T" << header.num_tries
+         << ".O" << std::hex << sample_nickname_opt_hash(header.nickname_opt) << std::dec << '.' << header.shard_index
+         << "of" << header.num_shards << ".runs";
+    return dir / name.str();
+}
+
+// 정렬된 keys를 차이의 LEB128 열로 덧붙인다.
+inline void encode_sorted_keys(std::span<NicknameKey const> const keys, std::vector<u8> &out)
+{
+    auto prev = NicknameKey();
+    for (auto const key : keys)
+    {
+        for (auto delta = key - prev; true; delta >>= 7)
+        {
+            if (delta < 0x80)
+            {
+                out.push_back(static_cast<u8>(delta));
+                break;
+            }
+            out.push_back(static_cast<u8>((delta & 0x7f) | 0x80));
+        }
+        prev = key;
+    }
+}
+
+// encode_sorted_keys로 기록한 num_keys개의 키를 out에 덧붙인다. 데이터가 모자라거나 남는다면 false를 반환한다.
+inline bool decode_sorted_keys(std::span<u8 const> const data, sz const num_keys, std::vector<NicknameKey> &out)
+{
+    auto key = NicknameKey();
+    auto pos = sz();
+    for (auto i = sz(); i < num_keys; ++i)
+    {
+        auto delta = NicknameKey();
+        for (auto shift = 0;; shift += 7)
+        {
+            if (data.size() <= pos || 64 <= shift)
+            {
+                return false;
+            }
+            auto const byte = data[pos++];
+            delta |= static_cast<NicknameKey>(byte & 0x7f) << shift;
+            if (byte < 0x80)
+            {
+                break;
+            }
+        }
+        key += delta;
+        out.push_back(key);
+    }
+    return pos == data.size();
+}
+
+// 헤더와 빈 목차를 먼저 쓰고, 파티션을 끝나는 순서대로 이어 쓴 뒤 finish에서 목차를 채운다.
+// 같은 디렉터리를 쓰는 다른 프로세스가 덜 쓴 파일을 읽거나 같은 파일에 섞어 쓰지 않도록, 임시 파일에 기록한 뒤
+// finish에서 이름을 바꾼다. write_partition은 여러 스레드에서 동시에 호출할 수 있다.
+class ShardRunsWriter
+{
+  public:
+    ShardRunsWriter(std::filesystem::path path, ShardRunsHeader const &header)
+        : path_(std::move(path)), tmp_path_(path_), partitions_(header.num_partitions)
+    {
+        tmp_path_ += ".tmp" + std::to_string(std::random_device()());
+        file_ = std::fopen(tmp_path_.string().c_str(), "wb");
+        if (file_ == nullptr)
+        {
+            spdlog::critical("failed to create shard runs file: {}", tmp_path_.string());
+            std::exit(-1);
+        }
+        write(&header, sizeof(header));
+        write(partitions_.data(), partitions_.size() * sizeof(ShardRunsPartition));
+        offset_ = sizeof(header) + partitions_.size() * sizeof(ShardRunsPartition);
+    }
+
+    ShardRunsWriter(ShardRunsWriter const &) = delete;
+    ShardRunsWriter &operator=(ShardRunsWriter const &) = delete;
+
+    ~ShardRunsWriter()
+    {
+        if (file_ != nullptr)
+        {
+            std::fclose(file_);
+            auto ec = std::error_code();
+            std::filesystem::remove(tmp_path_, ec);
+        }
+    }
+
+    // population과 probes는 정렬되어 있어야 한다.
+    void write_partition(sz const partition, std::span<NicknameKey const> const population,
+                         std::span<NicknameKey const> const probes)
+    {
+        auto data = std::vector<u8>();
+        encode_sorted_keys(population, data);
+        auto const population_bytes = data.size();
+        encode_sorted_keys(probes, data);
+
+        auto const lock = std::lock_guard(mutex_);
+        partitions_[partition] = ShardRunsPartition{offset_, population.size(), population_bytes, probes.size(),
+                                                    data.size() - population_bytes};
+        write(data.data(), data.size());
+        offset_ += data.size();
+    }
+
+    // 목차를 기록하고 파일을 닫은 뒤 path로 옮긴다. 기록한 바이트 수를 반환한다.
+    sz finish()
+    {
+        if (std::fseek(file_, sizeof(ShardRunsHeader), SEEK_SET) != 0)
+        {
+            fail();
+        }
+        write(partitions_.data(), partitions_.size() * sizeof(ShardRunsPartition));
+        if (std::fclose(std::exchange(file_, nullptr)) != 0)
+        {
+            fail();
+        }
+        auto ec = std::error_code();
+        std::filesystem::rename(tmp_path_, path_, ec);
+        if (ec)
+        {
+            std::filesystem::remove(tmp_path_, ec);
+            fail();
+        }
+        return offset_;
+    }
+
+  private:
+    void write(void const *const data, sz const size)
+    {
+        if (std::fwrite(data, 1, size, file_) != size)
+        {
+            fail();
+        }
+    }
+
+    [[noreturn]] void fail() const
+    {
+        spdlog::critical("failed to write shard runs file: {}", path_.string());
+        std::exit(-1);
+    }
+
+    std::filesystem::path path_;
+    std::filesystem::path tmp_path_;
+    std::FILE *file_ = nullptr;
+    std::vector<ShardRunsPartition> partitions_;
+    sz offset_ = 0;
+    std::mutex mutex_;
+};
+
+// 매핑한 샤드 파일. 파티션마다 사전 생성 키와 검사 키를 풀어 읽는다.
+class ShardRuns
+{
+  public:
+    // 읽을 수 없거나 형식이 맞지 않는다면 std::exit를 호출한다.
+    static ShardRuns open(std::filesystem::path const &path)
+    {
+        auto file = MappedFile::open(path);
+        if (!file)
+        {
+            spdlog::critical("failed to open shard runs file: {}", path.string());
+            std::exit(-1);
+        }
+        auto runs = ShardRuns(std::move(*file), path);
+        auto const data = runs.file_.view();
+        auto const table_size = KeyPartitions::NUM_PARTITIONS * sizeof(ShardRunsPartition);
+        if (data.size() < sizeof(ShardRunsHeader) + table_size)
+        {
+            runs.corrupted();
+        }
+        std::memcpy(&runs.header_, data.data(), sizeof(ShardRunsHeader));
+        if (runs.header_.magic != SHARD_RUNS_MAGIC || runs.header_.version != SHARD_RUNS_VERSION ||
+            runs.header_.num_partitions != KeyPartitions::NUM_PARTITIONS ||
+            runs.header_.num_shards <= runs.header_.shard_index)
+        {
+            runs.corrupted();
+        }
+        runs.partitions_.resize(KeyPartitions::NUM_PARTITIONS);
+        std::memcpy(runs.partitions_.data(), data.data() + sizeof(ShardRunsHeader), table_size);
+        for (auto const &partition : runs.partitions_)
+        {
+            if (data.size() < partition.offset || data.size() - partition.offset < partition.population_bytes ||
+                data.size() - partition.offset - partition.population_bytes < partition.probe_bytes)
+            {
+                runs.corrupted();
+            }
+        }
+        return runs;
+    }
+
+    ShardRunsHeader const &header() const noexcept
+    {
+        return header_;
+    }
+
+    std::filesystem::path const &path() const noexcept
+    {
+        return path_;
+    }
+
+    // 파티션의 사전 생성 키를 out에 덧붙인다. 한 샤드 안에서는 정렬되어 있으며 고유하다.
+    void append_population(sz const partition, std::vector<NicknameKey> &out) const
+    {
+        auto const &entry = partitions_[partition];
+        decode(entry.offset, entry.population_bytes, entry.num_population_keys, out);
+    }
+
+    // 파티션의 검사 키를 out에 덧붙인다. 한 샤드 안에서는 정렬되어 있다.
+    void append_probes(sz const partition, std::vector<NicknameKey> &out) const
+    {
+        auto const &entry = partitions_[partition];
+        decode(entry.offset + entry.population_bytes, entry.probe_bytes, entry.num_probe_keys, out);
+    }
+
+  private:
+    ShardRuns(MappedFile file, std::filesystem::path path) : file_(std::move(file)), path_(std::move(path))
+    {
+    }
+
+    void decode(u64 const offset, u64 const size, u64 const num_keys, std::vector<NicknameKey> &out) const
+    {
+        auto const *const data = reinterpret_cast<u8 const *>(file_.data()) + offset;
+        if (!decode_sorted_keys(std::span(data, static_cast<sz>(size)), static_cast<sz>(num_keys), out))
+        {
+            corrupted();
+        }
+    }
+
+    [[noreturn]] void corrupted() const
+    {
+        spdlog::critical("corrupted shard runs file: {}", path_.string());
+        std::exit(-1);
+    }
+
+    MappedFile file_;
+    std::filesystem::path path_;
+    ShardRunsHeader header_{};
+    std::vector<ShardRunsPartition> partitions_;
+};
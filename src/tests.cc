@@ -0,0 +1,383 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "batch_nickname_sampler.h"
+#include "composition_plan.h"
+#include "mapped_file.h"
+#include "nickname_key.h"
+#include "random_engines.h"
+#include "sample_nickname.h"
+#include "sample_nickname_opt.h"
+#include "shard_runs.h"
+#include "types.h"
+#include "word_db.h"
+
+// 엔진의 출력, 샤드 파일의 키 인코딩, 단어 DB 캐시, 닉네임 샘플러의 분포를 확인하는 테스트
+// 검사마다 실패를 로그로 남기고, 하나라도 실패했다면 EXIT_FAILURE를 반환한다. 난수는 모두 고정된 시드에서 뽑는다.
+
+class TestReport
+{
+  public:
+    void check(bool const passed, std::string_view const what)
+    {
+        ++num_checks_;
+        if (!passed)
+        {
+            ++num_failures_;
+            spdlog::error("실패: {}", what);
+        }
+    }
+
+    sz num_checks() const noexcept
+    {
+        return num_checks_;
+    }
+
+    sz num_failures() const noexcept
+    {
+        return num_failures_;
+    }
+
+  private:
+    sz num_checks_ = 0;
+    sz num_failures_ = 0;
+};
+
+template <typename RandomEngine>
+bool starts_with_outputs(RandomEngine random_engine, std::span<u64 const> const expected)
+{
+    return std::ranges::all_of(expected, [&](u64 const value) { return random_engine() == value; });
+}
+
+// 참조 구현의 공개된 출력과 비교한다.
+void test_engine_known_answers(TestReport &report)
+{
+    // http://prng.di.unimi.it/splitmix64.c, seed = 1234567
+    constexpr auto SPLITMIX64 = std::array<u64, 5>{6457827717110365317ULL, 3203168211198807973ULL,
+                                                   9817491932198370423ULL, 4593380528125082431ULL,
+                                                   16408922859458223821ULL};
+    report.check(starts_with_outputs(SplitMix64(1234567), SPLITMIX64), "SplitMix64(1234567)");
+
+    // http://prng.di.unimi.it/xoshiro256starstar.c, state = {1, 2, 3, 4}
+    constexpr auto XOSHIRO256SS = std::array<u64, 5>{11520ULL, 0ULL, 1509978240ULL, 1215971899390074240ULL,
+                                                     1216172134540287360ULL};
+    report.check(starts_with_outputs(Xoshiro256StarStar(std::array<u64, 4>{1, 2, 3, 4}), XOSHIRO256SS),
+                 "Xoshiro256StarStar({1, 2, 3, 4})");
+
+    // pcg-cpp의 pcg64 rng(42, 54)
+    constexpr auto PCG64 = std::array<u64, 6>{0x86b1da1d72062b68ULL, 0x1304aa46c9853d39ULL, 0xa3670e9e0dd50358ULL,
+                                              0xf9090e529a7dae00ULL, 0xc85b9fd837996f2cULL, 0x606121f8e3919196ULL};
+    report.check(starts_with_outputs(Pcg64(42, 0, 54, 0), PCG64), "Pcg64(42, 54)");
+
+    // Random123 kat_vectors의 philox4x32_10, ctr = {0, 0, 0, 0}, key = {0, 0}
+    // 출력 하나는 블록의 32비트 값 두 개를 (하위, 상위) 순서로 이어 붙인 것이다.
+    constexpr auto PHILOX4X32 = std::array<u64, 2>{0xe169c58d6627e8d5ULL, 0x9b00dbd8bc57ac4cULL};
+    report.check(starts_with_outputs(Philox4x32(0), PHILOX4X32), "Philox4x32(0)");
+    auto philox = Philox4x32(0);
+    for (auto i = 0; i < 5; ++i)
+    {
+        philox();
+    }
+    philox.seek(0);
+    report.check(philox() == PHILOX4X32[0] && philox() == PHILOX4X32[1], "Philox4x32::seek(0)");
+}
+
+template <typename Lazy, typename Reference>
+bool same_outputs(typename Reference::result_type const seed, sz const count)
+{
+    auto lazy = Lazy(seed);
+    auto reference = Reference(seed);
+    for (auto i = sz(); i < count; ++i)
+    {
+        if (lazy() != reference())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 첫 twist 전후와 두 번째 twist까지 std::mersenne_twister_engine과 같은 출력을 내야 한다.
+void test_lazy_mersenne_twister(TestReport &report)
+{
+    for (auto const seed : {5489U, 0U, 1U, 123456789U, 0xffffffffU})
+    {
+        report.check(same_outputs<LazyMt19937, std::mt19937>(seed, 2000),
+                     "LazyMt19937 == std::mt19937 (seed " + std::to_string(seed) + ")");
+    }
+    for (auto const seed : {5489ULL, 0ULL, 1ULL, 0xffffffffffffffffULL})
+    {
+        report.check(same_outputs<LazyMt19937_64, std::mt19937_64>(seed, 1000),
+                     "LazyMt19937_64 == std::mt19937_64 (seed " + std::to_string(seed) + ")");
+    }
+
+    // 표준이 정한 기본 시드의 10000번째 출력
+    auto mt = LazyMt19937();
+    auto mt_64 = LazyMt19937_64();
+    for (auto i = 1; i < 10000; ++i)
+    {
+        mt();
+        mt_64();
+    }
+    report.check(mt() == 4123659995U, "LazyMt19937 10000th output");
+    report.check(mt_64() == 9981545732273789042ULL, "LazyMt19937_64 10000th output");
+}
+
+void test_sorted_key_encoding(TestReport &report)
+{
+    auto keys = std::vector<NicknameKey>{0, 1, 127, 128, 16383, 16384, 1ULL << 35, (1ULL << 63) - 1, 1ULL << 63,
+                                         std::numeric_limits<NicknameKey>::max()};
+    auto random_engine = Xoshiro256StarStar(1);
+    for (auto i = 0; i < 1000; ++i)
+    {
+        keys.push_back(random_engine() >> (random_engine() % 64));
+    }
+    std::ranges::sort(keys);
+
+    auto data = std::vector<u8>();
+    encode_sorted_keys(keys, data);
+    auto decoded = std::vector<NicknameKey>();
+    report.check(decode_sorted_keys(data, keys.size(), decoded) && decoded == keys, "LEB128 round trip");
+
+    auto empty = std::vector<NicknameKey>();
+    report.check(decode_sorted_keys(std::span<u8 const>(), 0, empty) && empty.empty(), "LEB128 empty input");
+
+    decoded.clear();
+    report.check(!decode_sorted_keys(std::span(data).first(data.size() - 1), keys.size(), decoded),
+                 "LEB128 rejects truncated data");
+    decoded.clear();
+    report.check(!decode_sorted_keys(data, keys.size() + 1, decoded), "LEB128 rejects missing keys");
+
+    auto trailing = data;
+    trailing.push_back(0);
+    decoded.clear();
+    report.check(!decode_sorted_keys(trailing, keys.size(), decoded), "LEB128 rejects trailing data");
+
+    // 64비트를 넘는 차이는 올바른 인코딩이 아니다.
+    auto overlong = std::vector<u8>(10, 0x80);
+    overlong.push_back(0x01);
+    decoded.clear();
+    report.check(!decode_sorted_keys(overlong, 1, decoded), "LEB128 rejects overlong deltas");
+}
+
+// 단어 목록을 따옴표로 감싼 줄로 기록한다.
+void write_word_list(std::filesystem::path const &path, std::span<std::string_view const> const words)
+{
+    auto f = std::ofstream(path, std::ios::binary);
+    for (auto const word : words)
+    {
+        f << '"' << word << "\"\n";
+    }
+}
+
+bool same_word_db(WordDB const &a, WordDB const &b)
+{
+    return a.first_index == b.first_index && std::ranges::equal(a.offsets, b.offsets) && a.chars == b.chars &&
+           a.packed_words == b.packed_words && word_db_fingerprint(a) == word_db_fingerprint(b);
+}
+
+void test_word_db_cache(TestReport &report, std::filesystem::path const &dir)
+{
+    // 닉네임에 쓸 수 없는 줄과 빈 줄, 길이가 다른 단어들이 섞인 목록
+    constexpr auto WORDS = std::array<std::string_view, 12>{
+        "ant", "zebra", "ox", "kiwi", "no-dash", "", "elephant", "a", "banana", "x1y2z3", "abcdefghijklm", "Cat"};
+    auto const txt_path = dir / "words.txt";
+    write_word_list(txt_path, WORDS);
+
+    auto const parsed = load_word_db(txt_path);
+    auto const cache_path = get_word_db_cache_path(txt_path);
+    report.check(std::filesystem::exists(cache_path), "word db cache is written");
+    auto const opened = open_word_db_cache(txt_path);
+    report.check(opened && same_word_db(parsed, *opened), "word db cache is opened for the text path");
+    auto const cached = load_word_db(cache_path);
+    report.check(same_word_db(parsed, cached), "word db cache equals text parse");
+
+    // 앞뒤 오프셋은 맞지만 중간의 오프셋이 길이별 간격을 벗어난 캐시는 거부하고 텍스트를 다시 읽어야 한다.
+    auto bytes = std::string(cached.mapping.view());
+    auto const offsets_begin = sizeof(WordDBCacheHeader) + WORD_DB_CACHE_INDEX_SIZE;
+    auto offset = u32();
+    std::memcpy(&offset, bytes.data() + offsets_begin + sizeof(u32), sizeof(offset));
+    ++offset;
+    std::memcpy(bytes.data() + offsets_begin + sizeof(u32), &offset, sizeof(offset));
+    auto const corrupted_path = dir / "corrupted.bin";
+    std::ofstream(corrupted_path, std::ios::binary) << bytes;
+    auto corrupted = MappedFile::open(corrupted_path);
+    report.check(corrupted && !map_word_db_cache(std::move(*corrupted)), "word db cache rejects a misplaced offset");
+    // 매핑한 cached가 바뀌지 않도록 지운 뒤 새 파일로 만든다.
+    std::filesystem::remove(cache_path);
+    std::filesystem::copy_file(corrupted_path, cache_path);
+    report.check(!open_word_db_cache(txt_path), "corrupted word db cache is not opened");
+    report.check(same_word_db(parsed, load_word_db(txt_path)), "corrupted word db cache falls back to text parse");
+    report.check(parsed.first_index.back() == 9, "word db skips invalid lines");
+    report.check(parsed.word(parsed.first_index[3]) == "ant", "word db orders words by length");
+
+    auto other_words = std::vector<std::string_view>(WORDS.begin(), WORDS.end());
+    other_words.back() = "Dog";
+    write_word_list(dir / "other.txt", other_words);
+    report.check(word_db_fingerprint(load_word_db(dir / "other.txt")) != word_db_fingerprint(parsed),
+                 "word db fingerprint distinguishes lists");
+}
+
+// 두 표본의 도수가 같은 분포에서 나왔는지 보는 카이제곱 통계량. 두 표본의 크기는 같아야 한다.
+// 같은 분포라면 통계량은 자유도가 (칸 수 - 1)인 카이제곱 분포를 따르므로, 평균에서 표준 편차의 6배를 넘으면 다르다고
+// 본다. 시드가 고정되어 있으므로 결과는 실행마다 같다.
+class TwoSampleChiSquare
+{
+  public:
+    void add(u64 const cell, sz const sample)
+    {
+        ++counts_[cell][sample];
+    }
+
+    bool same_distribution() const noexcept
+    {
+        auto statistic = 0.0;
+        for (auto const &[cell, counts] : counts_)
+        {
+            auto const diff = static_cast<double>(counts[0]) - static_cast<double>(counts[1]);
+            statistic += diff * diff / static_cast<double>(counts[0] + counts[1]);
+        }
+        auto const dof = static_cast<double>(counts_.size() - 1);
+        return statistic <= dof + 6 * std::sqrt(2 * dof);
+    }
+
+  private:
+    std::unordered_map<u64, std::array<sz, 2>> counts_;
+};
+
+// sample(sample_idx)가 돌려주는 키 num_samples개씩의 분포를 비교한다.
+// 닉네임 전체와 위치별 문자의 분포를 함께 본다.
+template <typename Sample>
+std::pair<bool, bool> compare_key_distributions(sz const num_samples, Sample &&sample)
+{
+    auto keys = TwoSampleChiSquare();
+    auto chars = TwoSampleChiSquare();
+    for (auto sample_idx = sz(); sample_idx < 2; ++sample_idx)
+    {
+        for (auto i = sz(); i < num_samples; ++i)
+        {
+            auto const key = sample(sample_idx);
+            keys.add(key, sample_idx);
+            for (auto pos = sz(); pos < MAX_PACKED_NICKNAME_LEN; ++pos)
+            {
+                chars.add(pos << NICKNAME_SYMBOL_BITS | (key >> (pos * NICKNAME_SYMBOL_BITS) & 0x3f), sample_idx);
+            }
+        }
+    }
+    return std::pair(keys.same_distribution(), chars.same_distribution());
+}
+
+template <typename RandomEngine>
+void sample_batch_keys(BatchNicknameSampler const &sampler, RandomEngine &random_engine, std::vector<NicknameKey> &out)
+{
+    out.resize(BatchNicknameSampler::BATCH_SIZE);
+    sampler.sample(random_engine, out);
+}
+
+// BatchNicknameSampler와 구성 계획에서 뽑은 키는 sample_nickname_key와 같은 분포를 따라야 한다.
+// 닉네임 공간이 작은 옵션을 골라, 채움 문자열과 단어를 섞는 순서, 첫 글자의 대문자 변환까지 전체 키로 비교한다.
+void test_sampler_distributions(TestReport &report, std::filesystem::path const &dir)
+{
+    constexpr auto WORDS = std::array<std::string_view, 9>{"cat", "dog", "sun", "map", "key", "tree", "lamp",
+                                                           "river", "stone"};
+    auto const txt_path = dir / "sampler.txt";
+    write_word_list(txt_path, WORDS);
+    auto const word_db = load_word_db(txt_path);
+    constexpr auto NUM_SAMPLES = static_cast<sz>(1'000'000);
+
+    for (auto const &opt : {SampleNicknameOpt{4, 4, 3, 3, 2.7}, SampleNicknameOpt{6, 8, 3, 5, 2.7}})
+    {
+        auto const name = fmt::format("{{{}, {}, {}, {}, {}}}", opt.min_len, opt.max_len, opt.min_word_len,
+                                      opt.max_word_len, opt.mangling_factor);
+        auto reference_engine = Xoshiro256StarStar(2);
+        auto const sample_reference = [&]() { return sample_nickname_key(reference_engine, word_db, opt); };
+
+        auto const sampler = BatchNicknameSampler(word_db, opt);
+        auto batch_engine = Xoshiro256StarStar(3);
+        auto batch = std::vector<NicknameKey>();
+        auto const sample_batch = [&]() {
+            if (batch.empty())
+            {
+                sample_batch_keys(sampler, batch_engine, batch);
+            }
+            auto const key = batch.back();
+            batch.pop_back();
+            return key;
+        };
+        auto const [same_keys, same_chars] = compare_key_distributions(NUM_SAMPLES, [&](sz const sample_idx) {
+            return sample_idx == 0 ? sample_reference() : sample_batch();
+        });
+        report.check(same_keys, "BatchNicknameSampler key distribution " + name);
+        report.check(same_chars, "BatchNicknameSampler char distribution " + name);
+
+        auto const plans = CompositionPlans(word_db, opt);
+        auto plan_engine = Xoshiro256StarStar(4);
+        auto const [same_plan_keys, same_plan_chars] =
+            compare_key_distributions(NUM_SAMPLES, [&](sz const sample_idx) {
+                return sample_idx == 0 ? sample_reference() : sample_nickname_key(plan_engine, plans);
+            });
+        report.check(same_plan_keys, "plan-based key distribution " + name);
+        report.check(same_plan_chars, "plan-based char distribution " + name);
+    }
+
+    // 변형 문자 수가 다른 분포는 구별해야 한다. 그렇지 않다면 위의 비교는 의미가 없다.
+    auto const opt = SampleNicknameOpt{6, 8, 3, 5, 2.7};
+    auto other_opt = opt;
+    other_opt.mangling_factor = 1.0;
+    auto const sampler = BatchNicknameSampler(word_db, other_opt);
+    auto reference_engine = Xoshiro256StarStar(5);
+    auto batch_engine = Xoshiro256StarStar(6);
+    auto batch = std::vector<NicknameKey>();
+    auto const [same_keys, same_chars] = compare_key_distributions(NUM_SAMPLES / 10, [&](sz const sample_idx) {
+        if (sample_idx == 0)
+        {
+            return sample_nickname_key(reference_engine, word_db, opt);
+        }
+        if (batch.empty())
+        {
+            sample_batch_keys(sampler, batch_engine, batch);
+        }
+        auto const key = batch.back();
+        batch.pop_back();
+        return key;
+    });
+    report.check(!same_chars, "distribution check detects a different mangling factor");
+}
+
+int main()
+{
+    auto ec = std::error_code();
+    auto const dir =
+        std::filesystem::temp_directory_path(ec) / ("random-nickname-tests." + std::to_string(std::random_device()()));
+    if (ec || !std::filesystem::create_directories(dir, ec))
+    {
+        spdlog::critical("failed to create test directory: {}", dir.string());
+        return EXIT_FAILURE;
+    }
+
+    auto report = TestReport();
+    test_engine_known_answers(report);
+    test_lazy_mersenne_twister(report);
+    test_sorted_key_encoding(report);
+    test_word_db_cache(report, dir);
+    test_sampler_distributions(report, dir);
+    std::filesystem::remove_all(dir, ec);
+
+    spdlog::info("검사 {}개 중 {}개 실패", report.num_checks(), report.num_failures());
+    return report.num_failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "mapped_file.h"
+#include "nickname_key.h"
+#include "types.h"
+
+constexpr static auto MAX_NICKNAME_LEN = static_cast<sz>(12);
+
+// 모든 단어는 길이 순으로 chars에 연속해서 저장되며, i번째 단어는 chars[offsets[i], offsets[i + 1])이다.
+// first_index[len]은 길이가 len 미만인 단어의 개수이므로, 길이가 [min_len, max_len]인 단어들의 인덱스는
+// [first_index[min_len], first_index[max_len + 1]) 범위에 위치한다.
+// chars와 offsets는 텍스트에서 읽은 경우 char_storage, offset_storage를, 바이너리 캐시에서 읽은 경우 매핑된 파일을 가리킨다.
+// packed_words[i]는 i번째 단어를 pack_nickname한 키이며, MAX_PACKED_NICKNAME_LEN보다 긴 단어는 EMPTY_NICKNAME_KEY이다.
+struct WordDB
+{
+    std::string_view chars;
+    std::span<u32 const> offsets;
+    std::array<sz, MAX_NICKNAME_LEN + 2> first_index;
+    std::vector<NicknameKey> packed_words;
+
+    std::vector<char> char_storage;
+    std::vector<u32> offset_storage;
+    MappedFile mapping;
+
+    std::string_view word(sz const idx) const noexcept
+    {
+        return std::string_view(chars.data() + offsets[idx], offsets[idx + 1] - offsets[idx]);
+    }
+
+    sz num_words(sz const len) const noexcept
+    {
+        return first_index[len + 1] - first_index[len];
+    }
+
+    sz num_words(sz const min_len, sz const max_len) const noexcept
+    {
+        return first_index[max_len + 1] - first_index[min_len];
+    }
+};
+
+// 단어 목록을 구별하기 위한 FNV-1a 해시. first_index, offsets, chars를 차례로 섞으므로 텍스트에서 읽든 캐시에서 읽든
+// 같은 단어 목록이라면 값이 같다.
+inline u64 word_db_fingerprint(WordDB const &db) noexcept
+{
+    auto hash = static_cast<u64>(0xcbf29ce484222325);
+    auto const mix = [&hash](u64 const value) {
+        hash ^= value;
+        hash *= 0x100000001b3;
+    };
+    std::ranges::for_each(db.first_index, mix);
+    std::ranges::for_each(db.offsets, mix);
+    std::ranges::for_each(db.chars, [&mix](char const ch) { mix(static_cast<unsigned char>(ch)); });
+    return hash;
+}
+
+// 바이너리 캐시는 헤더, first_index, offsets, chars를 이 순서로 그대로 기록한 파일이다.
+// 바이트 순서와 MAX_NICKNAME_LEN이 같은 환경에서만 읽으므로 머신마다 따로 생성한다.
+struct WordDBCacheHeader
+{
+    std::array<char, 4> magic;
+    u32 version;
+    u32 max_word_len;
+    u32 reserved;
+};
+
+constexpr static auto WORD_DB_CACHE_MAGIC = std::array{'N', 'W', 'D', 'B'};
+constexpr static auto WORD_DB_CACHE_VERSION = static_cast<u32>(1);
+constexpr static auto WORD_DB_CACHE_INDEX_SIZE = sizeof(u64) * (MAX_NICKNAME_LEN + 2);
+
+inline bool is_word_db_cache(std::string_view const data) noexcept
+{
+    auto header = WordDBCacheHeader();
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    return header.magic == WORD_DB_CACHE_MAGIC && header.version == WORD_DB_CACHE_VERSION &&
+           header.max_word_len == MAX_NICKNAME_LEN;
+}
+
+inline std::filesystem::path get_word_db_cache_path(std::filesystem::path const &txt_path)
+{
+    auto cache_path = txt_path;
+    cache_path += ".bin";
+    return cache_path;
+}
+
+// 텍스트의 각 줄을 fn에 넘긴다. 마지막 줄은 개행으로 끝나지 않아도 되며, 줄 끝의 '\r'은 제거한다.
+template <typename Fn>
+void for_each_line(std::string_view const text, Fn &&fn)
+{
+    auto const *pos = text.data();
+    auto const *const end = text.data() + text.size();
+    while (pos < end)
+    {
+        auto const *newline = static_cast<char const *>(std::memchr(pos, '\n', static_cast<sz>(end - pos)));
+        auto const *const line_end = newline != nullptr ? newline : end;
+        auto line = std::string_view(pos, static_cast<sz>(line_end - pos));
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        fn(line);
+        pos = line_end + 1;
+    }
+}
+
+// 단어 목록의 한 줄은 따옴표로 감싼 단어 하나이다. 닉네임에 쓸 수 없는 단어는 빈 문자열을 돌려준다.
+inline std::string_view parse_word_line(std::string_view const line) noexcept
+{
+    if (line.length() < 2 || line.length() - 2 > MAX_NICKNAME_LEN)
+    {
+        return std::string_view();
+    }
+    auto const word = line.substr(1, line.length() - 2);
+    return std::ranges::all_of(word, &is_nickname_symbol) ? word : std::string_view();
+}
+
+inline void pack_words(WordDB &db)
+{
+    db.packed_words.resize(db.first_index.back());
+    for (auto i = sz(); i < db.packed_words.size(); ++i)
+    {
+        auto const word = db.word(i);
+        db.packed_words[i] = word.length() <= MAX_PACKED_NICKNAME_LEN ? pack_nickname(word) : EMPTY_NICKNAME_KEY;
+    }
+}
+
+// 텍스트를 두 번 훑는다. 처음에는 길이별 단어 수만 세고,
+// 두 번째에는 길이별 영역의 다음 위치에 단어를 바로 복사하므로 줄마다 메모리를 할당하지 않는다.
+inline WordDB parse_word_list(std::string_view const text)
+{
+    auto counts = std::array<sz, MAX_NICKNAME_LEN + 1>();
+    for_each_line(text, [&](std::string_view const line) {
+        if (auto const word = parse_word_line(line); !word.empty())
+        {
+            ++counts[word.length()];
+        }
+    });
+
+    auto db = WordDB();
+    auto char_begin = std::array<sz, MAX_NICKNAME_LEN + 2>();
+    db.first_index[0] = 0;
+    for (auto len = sz(); len < counts.size(); ++len)
+    {
+        db.first_index[len + 1] = db.first_index[len] + counts[len];
+        char_begin[len + 1] = char_begin[len] + len * counts[len];
+    }
+
+    // 길이가 같은 단어끼리는 크기가 같으므로 오프셋은 단어 수만으로 정해진다.
+    db.char_storage.resize(char_begin.back());
+    db.offset_storage.resize(db.first_index.back() + 1);
+    for (auto len = sz(); len < counts.size(); ++len)
+    {
+        for (auto i = sz(); i < counts[len]; ++i)
+        {
+            db.offset_storage[db.first_index[len] + i] = static_cast<u32>(char_begin[len] + i * len);
+        }
+    }
+    db.offset_storage.back() = static_cast<u32>(db.char_storage.size());
+
+    auto cursors = char_begin;
+    for_each_line(text, [&](std::string_view const line) {
+        if (auto const word = parse_word_line(line); !word.empty())
+        {
+            std::memcpy(db.char_storage.data() + cursors[word.length()], word.data(), word.length());
+            cursors[word.length()] += word.length();
+        }
+    });
+
+    db.chars = std::string_view(db.char_storage.data(), db.char_storage.size());
+    db.offsets = db.offset_storage;
+    pack_words(db);
+    return db;
+}
+
+// 매핑한 캐시를 파싱 없이 그대로 가리킨다. 형식이 맞지 않는 캐시는 std::nullopt를 돌려준다.
+// 길이가 같은 단어들은 간격이 일정하다고 가정하고 읽으므로(CompositionPlans의 WordBucket), 오프셋마다 그 길이의
+// 간격으로 놓여 있는지와 모든 문자가 닉네임 문자인지 확인한다.
+inline std::optional<WordDB> map_word_db_cache(MappedFile file)
+{
+    auto const data = file.view();
+    if (!is_word_db_cache(data) || data.size() < sizeof(WordDBCacheHeader) + WORD_DB_CACHE_INDEX_SIZE)
+    {
+        return std::nullopt;
+    }
+
+    auto db = WordDB();
+    auto first_index = std::array<u64, MAX_NICKNAME_LEN + 2>();
+    std::memcpy(first_index.data(), data.data() + sizeof(WordDBCacheHeader), WORD_DB_CACHE_INDEX_SIZE);
+    if (first_index[0] != 0 || !std::ranges::is_sorted(first_index))
+    {
+        return std::nullopt;
+    }
+    std::ranges::copy(first_index, db.first_index.begin());
+
+    auto const offsets_begin = sizeof(WordDBCacheHeader) + WORD_DB_CACHE_INDEX_SIZE;
+    if ((data.size() - offsets_begin) / sizeof(u32) <= first_index.back())
+    {
+        return std::nullopt;
+    }
+    auto const num_offsets = static_cast<sz>(first_index.back()) + 1;
+    auto const chars_begin = offsets_begin + sizeof(u32) * num_offsets;
+    db.offsets = std::span(reinterpret_cast<u32 const *>(data.data() + offsets_begin), num_offsets);
+    db.chars = data.substr(chars_begin);
+
+    auto offset = u64();
+    for (auto len = sz(); len <= MAX_NICKNAME_LEN; ++len)
+    {
+        for (auto i = db.first_index[len]; i < db.first_index[len + 1]; ++i, offset += len)
+        {
+            if (db.offsets[i] != offset)
+            {
+                return std::nullopt;
+            }
+        }
+    }
+    if (db.offsets.back() != offset || offset != db.chars.size() ||
+        !std::ranges::all_of(db.chars, &is_nickname_symbol))
+    {
+        return std::nullopt;
+    }
+    db.mapping = std::move(file);
+    pack_words(db);
+    return db;
+}
+
+// 텍스트 파일보다 나중에 생성된 올바른 캐시가 있다면 매핑한 캐시를, 아니라면 std::nullopt를 돌려준다.
+inline std::optional<WordDB> open_word_db_cache(std::filesystem::path const &txt_path)
+{
+    auto const cache_path = get_word_db_cache_path(txt_path);
+    auto ec = std::error_code();
+    auto const cache_time = std::filesystem::last_write_time(cache_path, ec);
+    if (ec || cache_time < std::filesystem::last_write_time(txt_path, ec) || ec)
+    {
+        return std::nullopt;
+    }
+    auto cache = MappedFile::open(cache_path);
+    return cache ? map_word_db_cache(std::move(*cache)) : std::nullopt;
+}
+
+inline std::filesystem::path get_wordlist_txt_path() noexcept
+{
+    auto const project_dir = std::filesystem::path(__FILE__).parent_path().parent_path();
+    return project_dir / "external" / "wordlist" / "wordlist-20210729.txt";
+}
+
+// 다른 프로세스가 같은 캐시를 동시에 읽거나 쓸 수 있으므로 임시 파일에 기록한 뒤 이름을 바꾼다.
+inline bool save_word_db_cache(WordDB const &db, std::filesystem::path const &cache_path)
+{
+    auto tmp_path = cache_path;
+    tmp_path += ".tmp" + std::to_string(std::random_device()());
+    auto ec = std::error_code();
+    {
+        auto f = std::ofstream(tmp_path, std::ios::binary);
+        auto const header = WordDBCacheHeader{WORD_DB_CACHE_MAGIC, WORD_DB_CACHE_VERSION, MAX_NICKNAME_LEN, 0};
+        auto first_index = std::array<u64, MAX_NICKNAME_LEN + 2>();
+        std::ranges::copy(db.first_index, first_index.begin());
+        f.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        f.write(reinterpret_cast<char const *>(first_index.data()), WORD_DB_CACHE_INDEX_SIZE);
+        f.write(reinterpret_cast<char const *>(db.offsets.data()),
+                static_cast<std::streamsize>(db.offsets.size_bytes()));
+        f.write(db.chars.data(), static_cast<std::streamsize>(db.chars.size()));
+        if (!f.flush())
+        {
+            f.close();
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp_path, cache_path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+// path는 텍스트 단어 목록이거나 바이너리 캐시이다. 텍스트라면 텍스트보다 나중에 생성된 올바른 캐시를 대신 읽고,
+// 그런 캐시가 없어 텍스트를 읽은 경우에는 다음 실행을 위해 캐시를 기록해 둔다.
+inline WordDB load_word_db(std::filesystem::path const &path)
+{
+    if (auto cache = open_word_db_cache(path))
+    {
+        return std::move(*cache);
+    }
+
+    auto file = MappedFile::open(path);
+    if (!file)
+    {
+        spdlog::critical("failed to open word list file");
+        std::exit(-1);
+    }
+
+    if (is_word_db_cache(file->view()))
+    {
+        auto db = map_word_db_cache(std::move(*file));
+        if (!db)
+        {
+            spdlog::critical("corrupted word db cache: {}", path.string());
+            std::exit(-1);
+        }
+        return std::move(*db);
+    }
+
+    auto db = parse_word_list(file->view());
+    if (!save_word_db_cache(db, get_word_db_cache_path(path)))
+    {
+        spdlog::warn("failed to write word db cache: {}", get_word_db_cache_path(path).string());
+    }
+    return db;
+}